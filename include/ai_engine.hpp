@@ -0,0 +1,61 @@
+#pragma once
+// ai_engine.hpp — 探索エンジンのコンパイル済み API（beatris_engine ライブラリ）
+// ====================================================================
+// * ai_search.hpp などの重いヘッダを含まないので、GUI / CLI / ボットから軽く使える
+//   （masks.hpp の mask_board を含む TU は 1 実行ファイルに 1 つだけにすること）
+// * 盤面は下から 1 段ずつの行ビット（bit x = x 列目）で渡す。ゲームのメモリ読みなど
+//   プラットフォーム依存の部分は呼ぶ側が持つ
+// ====================================================================
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ai {
+
+struct Weights;
+
+struct EnginePosition {
+    static constexpr int WIDTH  = 10;
+    static constexpr int HEIGHT = 24;
+    std::array<std::uint16_t, HEIGHT> rows{}; // rows[y] の bit x = (x, y) にブロック（y=0 が最下段）
+    std::string queue;                        // 現在のミノ + ネクスト（例 "TIOSZ"）
+    char        hold = 0;                     // ホールド中のミノ（0=空）
+};
+
+struct EngineMove {
+    bool   found    = false;     // 置ける手が無ければ false（以下は未設定）
+    char   piece    = 0;
+    bool   usedHold = false;
+    int    rot = 0, x = 0, y = 0;
+    int    score    = 0;         // 探索が選んだ葉の評価値
+    std::vector<std::string> inputs; // build_input_path のトークン列（"hold" … "hard"）
+    double searchMs = 0.0;       // 探索にかかった時間
+    double pathMs   = 0.0;       // 入力列の生成にかかった時間
+    bool   timedOut = false;     // 時間切れで depthMax より手前で止まったか
+};
+
+class Engine {
+public:
+    Engine();
+    ~Engine();
+    Engine(const Engine&)            = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // 1 回の think に使える時間 [ms]（0 以下なら無制限）
+    void set_time_limit(double ms);
+    // 評価係数（load_weights の形式のファイル）/ 埋め込みの既定値に戻す
+    void set_weights(const Weights& w);
+    void load_weights(const std::string& path);
+    void clear_weights();
+
+    // 局面から最善手を探す（毎回木を作り直す）
+    EngineMove think(const EnginePosition& pos);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace ai
@@ -16,9 +16,14 @@
 #include <array>
 #include <type_traits>
 #include <cstdint>
+#include <algorithm>
+#include <cstdlib>
 #include <bit>
 #include <experimental/simd>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
 
 using Board = reachability::board_t<10, 24>;
 using namespace reachability;
@@ -30,82 +35,215 @@ constexpr bool is_tspin(Board board, int x, int y) {
 
 namespace ai {
 
-namespace {                 // 無名名前空間 = この翻訳単位だけで参照
 //------------------------------------------------------------
-// ① 評価用の係数 —— まずは経験則値。あとで学習で最適化可能
+// 列ごとの高さ・穴数・凹凸・井戸（探索ノードに持たせて差分更新する）
+// 係数に依存しないので無名名前空間の外に置く
+//------------------------------------------------------------
+template<unsigned W>
+struct ColumnState {
+    std::array<std::uint8_t, W> height{};   // 各列の最上段 y+1 （empty なら 0）
+    std::array<std::uint8_t, W> holes{};    // 各列の最上段より下の空白
+    std::array<std::uint8_t, W> bump{};     // |height[x] - height[x+1]|（右端の列は 0）
+    std::array<std::uint8_t, W> well{};     // 列 x の井戸の深さ（両隣より低いセル数。壁の高さは H）
+    int holeSum = 0, heightSum = 0, bumpSum = 0, wellSum = 0;   // 上の 4 つの全列合計
+
+    bool operator==(const ColumnState&) const = default;
+};
+
+// 列 [x0, x1] の高さが変わったあと、凹凸（x0-1..x1）と井戸（x0-1..x1+1）を更新する
+template<unsigned H, unsigned W>
+void refresh_neighbours(ColumnState<W>& cs, int x0, int x1)
+{
+    constexpr int w = static_cast<int>(W);
+    for (int x = std::max(x0 - 1, 0); x <= std::min(x1, w - 2); ++x) {
+        const int b = std::abs(cs.height[x] - cs.height[x+1]);
+        cs.bumpSum += b - cs.bump[x];
+        cs.bump[x]  = static_cast<std::uint8_t>(b);
+    }
+    for (int x = std::max(x0 - 1, 0); x <= std::min(x1 + 1, w - 1); ++x) {
+        const int left  = (x == 0     ? H : cs.height[x-1]);
+        const int right = (x == w - 1 ? H : cs.height[x+1]);
+        const int top   = cs.height[x];
+        const int d     = (top < left && top < right) ? std::min(left, right) - top : 0;
+        cs.wellSum += d - cs.well[x];
+        cs.well[x]  = static_cast<std::uint8_t>(d);
+    }
+}
+
+template<unsigned W, unsigned H>
+ColumnState<W> column_state(const reachability::board_t<W,H>& bd)
+{
+    const auto cols = bd.columns();
+    ColumnState<W> cs;
+    for (int x = 0; x < static_cast<int>(W); ++x) {
+        cs.height[x] = static_cast<std::uint8_t>(cols.height[x]);
+        cs.holes[x]  = static_cast<std::uint8_t>(cols.holes[x]);
+        cs.heightSum += cs.height[x];
+        cs.holeSum   += cs.holes[x];
+    }
+    refresh_neighbours<H>(cs, 0, static_cast<int>(W) - 1);
+    return cs;
+}
+
+// ライン消去なしでミノ piece（置いたセルだけの盤面）を足したときの差分更新
+// 高さ・穴を直すのはミノのある列（最大 4 列）だけ、凹凸・井戸はその両隣まで。
+// ミノの列内のセルは縦に連続している
+//   * 最上段より上に置いた → 隙間が穴になり、高さがミノの上端になる
+//   * 最上段より下に差し込んだ → 埋めたセルは元々穴
+template<unsigned W, unsigned H>
+void place_update(ColumnState<W>& cs, const reachability::board_t<W,H>& piece)
+{
+    std::uint8_t lo[W], hi[W];
+    std::uint32_t touched = 0;
+    piece.list_bits_256([&](std::uint8_t x, std::uint8_t y){
+        if (!(touched >> x & 1)) { lo[x] = hi[x] = y; touched |= 1u << x; }
+        else { lo[x] = std::min(lo[x], y); hi[x] = std::max(hi[x], y); }
+    });
+    if (!touched) return;
+    const int x0 = std::countr_zero(touched);
+    const int x1 = 31 - std::countl_zero(touched);
+    for (; touched; touched &= touched - 1) {
+        const int x = std::countr_zero(touched);
+        const int h = cs.height[x];
+        const int holes = cs.holes[x];
+        if (lo[x] >= h) {
+            cs.holes[x]  += static_cast<std::uint8_t>(lo[x] - h);
+            cs.height[x]  = static_cast<std::uint8_t>(hi[x] + 1);
+        } else if (hi[x] >= h) {
+            cs.holes[x]  -= static_cast<std::uint8_t>(h - lo[x]);
+            cs.height[x]  = static_cast<std::uint8_t>(hi[x] + 1);
+        } else {
+            cs.holes[x]  -= static_cast<std::uint8_t>(hi[x] - lo[x] + 1);
+        }
+        cs.heightSum += cs.height[x] - h;
+        cs.holeSum   += cs.holes[x] - holes;
+    }
+    refresh_neighbours<H>(cs, x0, x1);
+}
+
 //------------------------------------------------------------
-constexpr int  W_LINES      = +40;   // 消した行数 (n² で掛ける)
-constexpr int  W_HOLES      = -20;   // 穴の個数
-constexpr int  W_HEIGHT     =  -1;   // 各列高さの合計
-constexpr int  W_BUMPINESS  =  -1;   // 隣接列の高さ差
-constexpr int  W_WELLS      =  -3;   // 井戸（両隣より低い列）の深さ合計
+// ① 評価用の係数 —— まずは経験則値。あとで学習で最適化可能
+//   * 実行時: load_weights() でファイルから読み、evaluate(..., weights) に渡す
+//   * 本番  : evaluate<W,H,WEIGHTS>() で係数を定数として埋め込む（既定は DEFAULT_WEIGHTS）
+//   どちらも weighted_sum() を通るので同じ係数なら同じ値になる
 //------------------------------------------------------------
+struct Weights {
+    int lines     = +40;   // 消した行数 (n² で掛ける)
+    int holes     = -20;   // 穴の個数
+    int height    =  -1;   // 各列高さの合計
+    int bumpiness =  -1;   // 隣接列の高さ差
+    int wells     =  -3;   // 井戸（両隣より低い列）の深さ合計
+
+    constexpr bool operator==(const Weights&) const = default;
+};
+inline constexpr Weights DEFAULT_WEIGHTS{};
+
+// "key = value" を 1 行ずつ読む。# 以降はコメント、書かれていない係数は既定値のまま
+//   lines / holes / height / bumpiness / wells
+inline Weights parse_weights(std::istream& in)
+{
+    Weights w;
+    std::string line;
+    for (int lineNo = 1; std::getline(in, line); ++lineNo) {
+        if (const auto c = line.find('#'); c != std::string::npos) line.erase(c);
+        const auto eq = line.find('=');
+        std::istringstream keyIn(line.substr(0, eq));
+        std::string key;
+        if (!(keyIn >> key)) continue;            // 空行
+        if (eq == std::string::npos)
+            throw std::runtime_error("weights: line " + std::to_string(lineNo) + ": missing '='");
+
+        std::istringstream valIn(line.substr(eq + 1));
+        int value = 0;
+        std::string rest;
+        if (!(valIn >> value) || (valIn >> rest))
+            throw std::runtime_error("weights: line " + std::to_string(lineNo) + ": bad value for " + key);
+
+        if      (key == "lines")     w.lines     = value;
+        else if (key == "holes")     w.holes     = value;
+        else if (key == "height")    w.height    = value;
+        else if (key == "bumpiness") w.bumpiness = value;
+        else if (key == "wells")     w.wells     = value;
+        else throw std::runtime_error("weights: line " + std::to_string(lineNo) + ": unknown key " + key);
+    }
+    return w;
+}
+
+inline Weights load_weights(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("weights: cannot open " + path);
+    return parse_weights(in);
+}
+
+// parse_weights で読める形式で書き出す
+inline void write_weights(std::ostream& out, const Weights& w)
+{
+    out << "lines = "     << w.lines     << '\n'
+        << "holes = "     << w.holes     << '\n'
+        << "height = "    << w.height    << '\n'
+        << "bumpiness = " << w.bumpiness << '\n'
+        << "wells = "     << w.wells     << '\n';
+}
+
+namespace {                 // 無名名前空間 = この翻訳単位だけで参照
 
 //------------------------------------------------------------
-// ② 高さ・穴数などを 1 パスで算出
+// ② 列状態の合計から評価の項を取り出す（合計は ColumnState が持っているので O(1)）
 //------------------------------------------------------------
 template<unsigned W, unsigned H>
 struct Stats {
-    int height[W]      = {};   // 各列の最上段 y+1 （empty なら 0）
     int holes          = 0;    // 穴 = 列の最初のブロックの下にある空白
     int wellDepthSum   = 0;    // 井戸の深さ（周囲より低いセル）
     int aggHeight      = 0;    // 列高さの合計
     int bumpiness      = 0;    // |h[i]-h[i+1]| の合計
 
     template<class Board>
-    Stats(const Board& bd)
-    {
-        // 高さと穴を列単位で計算
-        for (int x = 0; x < static_cast<int>(W); ++x) {
-            bool blockFound = false;
-            for (int y = static_cast<int>(H) - 1; y >= 0; --y) {
-                if (bd.get(x, y)) {
-                    if (!blockFound) {
-                        height[x] = y + 1;          // 最上段
-                        blockFound = true;
-                    }
-                } else if (blockFound) {
-                    ++holes;                        // ブロックより下の空白
-                }
-            }
-        }
-
-        // 井戸深さ：左右より低いセル数
-        for (int x = 0; x < static_cast<int>(W); ++x) {
-            int left  = (x == 0          ? H : height[x-1]);
-            int right = (x == static_cast<int>(W)-1 ? H : height[x+1]);
-            int top   = height[x];
-            if (top < left && top < right) {
-                wellDepthSum += std::min(left, right) - top;
-            }
-        }
+    Stats(const Board& bd) : Stats(column_state(bd)) {}
 
-        // 集約高さ・バンピネス
-        for (int x = 0; x < static_cast<int>(W); ++x) {
-            aggHeight += height[x];
-            if (x+1 < static_cast<int>(W))
-                bumpiness += std::abs(height[x] - height[x+1]);
-        }
-    }
+    Stats(const ColumnState<W>& cs)
+        : holes(cs.holeSum), wellDepthSum(cs.wellSum), aggHeight(cs.heightSum), bumpiness(cs.bumpSum) {}
 };
 
 //------------------------------------------------------------
 // ③ 重み付き合計を返す評価関数
 //------------------------------------------------------------
 template<unsigned W, unsigned H>
-int evaluate(const reachability::board_t<W,H>& board,
+constexpr int weighted_sum(const Stats<W,H>& st, int linesCleared, const Weights& w)
+{
+    return w.lines     * linesCleared * linesCleared   // n 行同時消しを強く評価
+         + w.holes     * st.holes
+         + w.height    * st.aggHeight
+         + w.bumpiness * st.bumpiness
+         + w.wells     * st.wellDepthSum;
+}
+
+// 係数を実行時に渡す版（チューニング・比較用）
+template<unsigned W, unsigned H>
+int evaluate(const ColumnState<W>& cs, int linesCleared, const Weights& w)
+{
+    return weighted_sum(Stats<W,H>(cs), linesCleared, w);
+}
+
+// 係数をコンパイル時に埋め込む版（探索の既定）
+template<unsigned W, unsigned H, Weights WEIGHTS = DEFAULT_WEIGHTS>
+int evaluate(const ColumnState<W>& cs,
              int linesCleared /* board.clear_full_lines() の戻り値 */)
 {
-    const Stats<W,H> st(board);
+    return weighted_sum(Stats<W,H>(cs), linesCleared, WEIGHTS);
+}
 
-    int score =
-          W_LINES     * linesCleared * linesCleared   // n 行同時消しを強く評価
-        + W_HOLES     * st.holes
-        + W_HEIGHT    * st.aggHeight
-        + W_BUMPINESS * st.bumpiness
-        + W_WELLS     * st.wellDepthSum;
+template<unsigned W, unsigned H, Weights WEIGHTS = DEFAULT_WEIGHTS>
+int evaluate(const reachability::board_t<W,H>& board,
+             int linesCleared /* board.clear_full_lines() の戻り値 */)
+{
+    return evaluate<W,H,WEIGHTS>(column_state(board), linesCleared);
+}
 
-    return score;
+template<unsigned W, unsigned H>
+int evaluate(const reachability::board_t<W,H>& board, int linesCleared, const Weights& w)
+{
+    return evaluate<W,H>(column_state(board), linesCleared, w);
 }
 
 } // ←無名名前空間終わり
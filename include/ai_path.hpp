@@ -1,13 +1,14 @@
 #pragma once
 #include <vector>
 #include <string>
-#include <queue>
+#include <stdexcept>
 #include <array>
 #include <optional>
 #include <limits>
 #include <algorithm>
 #include <type_traits>
 #include "ai_search.hpp"  // Board, RS, ai::Step
+#include "findfinalattachableminostates.hpp"
 
 namespace ai {
 
@@ -37,38 +38,17 @@ inline int total_cost(const std::vector<std::string>& path, const TokenCost& c)
     return t;
 }
 
-// --- 低レベル：衝突チェック（盤外=2／ブロック=1 は不可） ---------------------------
+// --- 低レベル：衝突チェック（盤外・ブロックとの重なりは不可） ----------------------
+// PieceTable の盤面と AND 1 回（盤外は SENTINEL ビットで同じ AND に載せる）
+// 不正なミノ文字は表を引かずに「置けない」（collides / fits が INVALID_ID を見る）
 inline bool can_place(const Board& bd, char piece, int x, int y, int rot){
-    bool ok = true;
-    reachability::blocks::call_with_block<RS>(piece, [&]<auto B>{
-        const int idx = B.mino_index[rot % B.ORIENTATIONS];
-        const auto& cs = B.minos[idx];
-        for (const auto& c : cs) {
-            const int gx = x + c[0];
-            const int gy = y + c[1];
-            int v = bd.get(gx, gy);         // 0=empty, 1=block, 2=OOB
-            if (v != 0){ ok = false; return; }
-        }
-    });
-    return ok;
+    return !PieceTable::collides(bd, piece, rot, x, y);
 }
 
 // --- 「最終配置の上が空か」を判定（上に1つでもあれば false） ----------------------
+// 各セルの真上から天井までの列マスクと AND 1 回
 inline bool is_clear_above(const Board& bd, char piece, int gx, int gy, int grot){
-    bool ok = true;
-    reachability::blocks::call_with_block<RS>(piece, [&]<auto B>{
-        const int idx = B.mino_index[grot % B.ORIENTATIONS];
-        const auto& cs = B.minos[idx];
-        for (const auto& c : cs){
-            const int x = gx + c[0];
-            const int y = gy + c[1];
-            for (int yy = y + 1; yy < Board::height; ++yy){ // final より上
-                int v = bd.get(x, yy); // 0=空, 1=ブロック
-                if (v != 0){ ok = false; return; }
-            }
-        }
-    });
-    return ok;
+    return PieceTable::fits(piece, grot, gx, gy) && PieceTable::clear_above(bd, piece, grot, gx, gy);
 }
 
 struct RotResult { int x, y, rot; };
@@ -102,129 +82,212 @@ inline std::optional<RotResult> try_rotate(const Board& bd, char piece,
     return res;
 }
 
-// --- 重み付き最短経路（Dijkstra） -------------------------------------------------
-// 返り値: トークン列（必要なら先頭に "hold"、末尾に "hard" 付き）
-inline std::vector<std::string>
-build_input_path(const Board& bd, const Step& goal, const TokenCost& cost = {}) {
-    std::vector<std::string> out;
-    if (goal.usedHold) out.push_back("hold");  // 定数分なので探索の相対比較には影響なし
+// --- 入力コストで層にした到達可能性（bitboard 版の最短経路） ------------------------
+// layer(d)[r] = 向き r で、入力コストの合計がちょうど d で初めて届く位置の集合
+//   （座標はミノ形状の座標系 = binary_bfs / Step と同じ）
+// * 層 d は 層 d-コスト の集合に 左右・ソフト・回転（SRS のキック順）を 1 回ずつ
+//   当てて作る。コストは正の整数なので、層を順に作るだけで Dijkstra と同じ最短コストになる
+// * 経路は層を逆にたどって復元する（各手の直前の層に前の位置があるかを見るだけ）
+// * コスト 0 の入力は 1 として扱う
+class InputLayers {
+public:
+    static constexpr int MAX_ORIENT = 4;
+    using Layer = std::array<Board, MAX_ORIENT>;
 
-    // 初期スポーン（必要なら引数化してね）
-    constexpr int W = Board::width, H = Board::height;
-    constexpr int SPAWN_X = 4, SPAWN_Y = 20;
-    const char piece = goal.piece;
-    struct S { int x,y,rot; };
-    const S start{SPAWN_X, SPAWN_Y, 0};
-    const S target{goal.x, goal.y, int(goal.rot)};
+    struct State { int x, y, rot, cost; };
 
-    if (!can_place(bd, piece, start.x, start.y, start.rot)) {
-        throw std::runtime_error("Spawn blocked: cannot place piece at initial position");
-        out.push_back("hard");
-        return out; // 湧き潰れ
+    InputLayers(const Board& bd, char piece, const TokenCost& cost = {},
+                bool allowSoft = true, int spawnX = 4, int spawnY = 20)
+        : board_(bd), piece_(piece), allowSoft_(allowSoft)
+    {
+        cost_ = {std::max(1, cost.left), std::max(1, cost.right), std::max(1, cost.soft),
+                 std::max(1, cost.cw),   std::max(1, cost.ccw),   cost.hard, cost.hold};
+        maxCost_ = std::max({cost_.left, cost_.right, cost_.cw, cost_.ccw, allowSoft ? cost_.soft : 1});
+
+        reachability::blocks::call_with_block<RS>(piece, [&]<auto B>{
+            using Block = std::decay_t<decltype(B)>;
+            orientations_ = Block::ORIENTATIONS;
+            reachability::static_for<Block::ORIENTATIONS>([&](auto r){
+                shape_[r]  = B.mino_index[r];
+                usable_[r] = reachability::search::usable_positions<B.minos[B.mino_index[r]]>(bd);
+            });
+        });
+
+        Layer first{};
+        if (usable_[0].get(spawnX, spawnY) == 1) first[0].set(spawnX, spawnY);
+        reached_ = first;
+        layers_.reserve(64);
+        layers_.push_back(first);
+        idle_ = first[0].any() ? 0 : maxCost_;
     }
 
-    // 直落ち（soft不要）判定：ゴールの真上にブロックが無ければ true
-    bool straight_drop = is_clear_above(bd, piece, target.x, target.y, target.rot);
+    bool spawn_ok() const { return layers_[0][0].any(); }
+    int  depth()    const { return static_cast<int>(layers_.size()) - 1; }
+    const Layer& layer(int d) const { return layers_[d]; }
 
-    // Dijkstra
-    static int  dist[W][H][4];
-    static bool vis [W][H][4];
-    struct Parent { int px,py,prot; char act; };
-    static Parent par[W][H][4];
+    // 次の層を作る。直近 maxCost 層がすべて空なら（もう何も届かない）false
+    bool grow()
+    {
+        if (idle_ >= maxCost_) return false;
+        Layer next{};
+        reachability::blocks::call_with_block<RS>(piece_, [&]<auto B>{ grow_impl<B>(next); });
+        bool any = false;
+        for (int r = 0; r < orientations_; ++r) {
+            next[r]    &= ~reached_[r];
+            reached_[r] |= next[r];
+            any = any || next[r].any();
+        }
+        layers_.push_back(next);
+        idle_ = any ? 0 : idle_ + 1;
+        return true;
+    }
+
+    // goal へ最小コストで届く状態（straight なら goal の列・形状で届けばよい＝あとはハードドロップ）
+    std::optional<State> find(int gx, int gy, int grot, bool straight)
+    {
+        const int shape = shape_[grot % orientations_];
+        for (int d = 0;; ++d) {
+            if (d > depth() && !grow()) return std::nullopt;
+            for (int r = 0; r < orientations_; ++r) {
+                if (shape_[r] != shape) continue;
+                const Board& L = layers_[d][r];
+                if (!straight) {
+                    if (L.get(gx, gy) == 1) return State{gx, gy, r, d};
+                    continue;
+                }
+                for (int y = Board::height - 1; y >= 0; --y)
+                    if (L.get(gx, y) == 1) return State{gx, y, r, d};
+            }
+        }
+    }
 
-    for (int x=0;x<W;++x) for (int y=0;y<H;++y) for (int r=0;r<4;++r){
-        dist[x][y][r] = std::numeric_limits<int>::max();
-        vis [x][y][r] = false;
-        par [x][y][r] = {-1,-1,-1,0};
+    // spawn から s までの入力列（hold / hard は含まない）
+    std::vector<std::string> path_to(State s) const
+    {
+        std::vector<std::string> tail;
+        while (s.cost > 0) {
+            const State p = predecessor(s, tail);
+            s = p;
+        }
+        std::reverse(tail.begin(), tail.end());
+        return tail;
     }
 
-    auto idx_ok = [&](int x,int y,int r){
-        return (0<=x && x<W && 0<=y && y<H && 0<=r && r<4);
-    };
+private:
+    bool in_layer(int d, int x, int y, int r) const
+    {
+        return d >= 0 && layers_[d][r].get(x, y) == 1;
+    }
 
-    using QN = std::pair<int, S>; // (cost, state)
-    auto cmp = [](const QN& a, const QN& b){ return a.first > b.first; };
-    std::priority_queue<QN, std::vector<QN>, decltype(cmp)> pq(cmp);
+    template<auto B>
+    void grow_impl(Layer& next) const
+    {
+        using Block = std::decay_t<decltype(B)>;
+        const int d = depth() + 1;
+        auto from = [&](int c) -> const Layer* { return d - c >= 0 ? &layers_[d - c] : nullptr; };
 
-    dist[start.x][start.y][start.rot] = 0;
-    pq.push({0, start});
+        reachability::static_for<Block::ORIENTATIONS>([&](auto r){
+            if (const Layer* L = from(cost_.left))  next[r] |= (*L)[r].template move<coord{-1, 0}>();
+            if (const Layer* R = from(cost_.right)) next[r] |= (*R)[r].template move<coord{ 1, 0}>();
+            if (allowSoft_)
+                if (const Layer* S = from(cost_.soft)) next[r] |= (*S)[r].template move<coord{0, -1}>();
+            next[r] &= usable_[r];
+        });
 
+        if constexpr (Block::ROTATIONS > 0) {
+            reachability::static_for<Block::ORIENTATIONS>([&](auto i){
+                reachability::static_for<Block::ROTATIONS>([&](auto j){
+                    const Layer* src = from(j == 0 ? cost_.cw : cost_.ccw);
+                    if (!src) return;
+                    constexpr int target = Block::rotation_target(i, j);
+                    Board temp = (*src)[i];
+                    Board to;
+                    // binary_bfs と同じ: 先に成功したキックの位置だけを残す
+                    reachability::static_for<Block::KICK_PER_ROTATION>([&](auto k){
+                        to   |= temp.template move<B.kicks[i][j][k]>();
+                        temp &= ~usable_[target].template move<-B.kicks[i][j][k]>();
+                    });
+                    next[target] |= to & usable_[target];
+                });
+            });
+        }
+    }
 
-    auto relax = [&](const S& from, const S& to, char act, int w){
-        if (!idx_ok(to.x,to.y,to.rot)) return;
-        if (!can_place(bd, piece, to.x,to.y,to.rot)) return;
-        int nd = dist[from.x][from.y][from.rot] + w;
-        if (nd < dist[to.x][to.y][to.rot]) {
-            dist[to.x][to.y][to.rot] = nd;
-            par[to.x][to.y][to.rot] = {from.x,from.y,from.rot,act};
-            pq.push({nd, to});
+    // s に 1 手で入ってくる、1 つ前の層の状態（探す順: 左 右 ソフト cw ccw）
+    State predecessor(const State& s, std::vector<std::string>& tail) const
+    {
+        if (in_layer(s.cost - cost_.left, s.x + 1, s.y, s.rot)) {
+            tail.push_back("left");  return {s.x + 1, s.y, s.rot, s.cost - cost_.left};
         }
-    };
-
-    while(!pq.empty()){
-        auto [d, s] = pq.top(); pq.pop();
-        if (vis[s.x][s.y][s.rot]) continue;
-        vis[s.x][s.y][s.rot] = true;
-
-        // 到達条件を切替
-        bool same_shape_rot = false;
-        switch (piece) {
-            case 'O':
-                same_shape_rot = true;                          // どのrotでも同形
-                break;
-            case 'S': case 'Z': case 'I':
-                same_shape_rot = ((s.rot & 1) == (target.rot & 1)); // 0/2, 1/3 を同形扱い
-                break;
-            default:
-                same_shape_rot = (s.rot == target.rot);         // J/L/T は完全一致
-                break;
+        if (in_layer(s.cost - cost_.right, s.x - 1, s.y, s.rot)) {
+            tail.push_back("right"); return {s.x - 1, s.y, s.rot, s.cost - cost_.right};
         }
-        bool reached;
-        if (straight_drop) {
-            reached = (s.x == target.x && same_shape_rot);
-        } else {
-            reached = (s.x == target.x && s.y == target.y && same_shape_rot);
-            if (s.x == target.x && s.y == target.y && !reached) {
-                std::cout << "[WARN] target.rot=" << target.rot
-                        << " s.rot=" << s.rot << " (same_shape=0)\n";
-            }
+        if (allowSoft_ && in_layer(s.cost - cost_.soft, s.x, s.y + 1, s.rot)) {
+            tail.push_back("soft");  return {s.x, s.y + 1, s.rot, s.cost - cost_.soft};
         }
-
-
-        if (reached) {
-            // 復元
-            std::vector<std::string> tail;
-            for (Parent p = par[s.x][s.y][s.rot]; p.px!=-1; p = par[p.px][p.py][p.prot]){
-                switch(p.act){
-                    case 'L': tail.push_back("left"); break;
-                    case 'R': tail.push_back("right"); break;
-                    case 'S': tail.push_back("soft"); break;
-                    case 'C': tail.push_back("cw");   break;
-                    case 'Z': tail.push_back("ccw");  break;
+        std::optional<State> found;
+        reachability::blocks::call_with_block<RS>(piece_, [&]<auto B>{
+            using Block = std::decay_t<decltype(B)>;
+            if constexpr (Block::ROTATIONS > 0) {
+                for (int j = 0; j < Block::ROTATIONS && !found; ++j) {
+                    const int c = (j == 0 ? cost_.cw : cost_.ccw);
+                    for (int i = 0; i < Block::ORIENTATIONS && !found; ++i) {
+                        if (Block::rotation_target(i, j) != s.rot) continue;
+                        for (const auto& k : B.kicks[i][j]) {
+                            const int px = s.x - k[0], py = s.y - k[1];
+                            if (!in_layer(s.cost - c, px, py, i)) continue;
+                            const auto r = try_rotate(board_, piece_, px, py, i, j);
+                            if (r && r->x == s.x && r->y == s.y && r->rot == s.rot) {
+                                tail.push_back(j == 0 ? "cw" : "ccw");
+                                found = State{px, py, i, s.cost - c};
+                                break;
+                            }
+                        }
+                    }
                 }
             }
-            std::reverse(tail.begin(), tail.end());
-            out.insert(out.end(), tail.begin(), tail.end());
-            out.push_back("hard"); // 最後に確定
-            return out;
-        }
+        });
+        if (!found) throw std::logic_error("InputLayers: broken layer chain");
+        return *found;
+    }
+
+    Board              board_;
+    char               piece_;
+    bool               allowSoft_;
+    TokenCost          cost_;
+    int                maxCost_      = 1;
+    int                orientations_ = 1;
+    int                idle_         = 0;   // 末尾から続く空の層の数
+    std::array<int, MAX_ORIENT> shape_{};   // 向き → 形状 index
+    Layer              usable_{};           // 向きごとの置ける位置
+    Layer              reached_{};
+    std::vector<Layer> layers_;
+};
 
-        // 遷移（左右・回転は常に展開）
-        relax(s, S{s.x-1, s.y,   s.rot}, 'L', cost.left);
-        relax(s, S{s.x+1, s.y,   s.rot}, 'R', cost.right);
+// --- 最小コストの入力列 -----------------------------------------------------------
+// 返り値: トークン列（必要なら先頭に "hold"、末尾に "hard" 付き）
+inline std::vector<std::string>
+build_input_path(const Board& bd, const Step& goal, const TokenCost& cost = {}) {
+    std::vector<std::string> out;
+    if (goal.usedHold) out.push_back("hold");  // 定数分なので探索の相対比較には影響なし
 
-        if (auto cw = try_rotate(bd, piece, s.x, s.y, s.rot, 0))
-            relax(s, S{cw->x,cw->y,cw->rot}, 'C', cost.cw);
-        if (auto ccw = try_rotate(bd, piece, s.x, s.y, s.rot, 1))
-            relax(s, S{ccw->x,ccw->y,ccw->rot}, 'Z', cost.ccw);
+    // 初期スポーン（必要なら引数化してね）
+    constexpr int SPAWN_X = 4, SPAWN_Y = 20;
+    const char piece = goal.piece;
 
-        // soft は「直落ち不可」モードのときだけ展開
-        if (!straight_drop)
-            relax(s, S{s.x,   s.y-1, s.rot}, 'S', cost.soft);
+    if (!can_place(bd, piece, SPAWN_X, SPAWN_Y, 0)) {
+        throw std::runtime_error("Spawn blocked: cannot place piece at initial position");
     }
 
-    // 到達不可
-    out.push_back("hard");
+    // 直落ち（soft不要）判定：ゴールの真上にブロックが無ければ、列と形状が合えばハードドロップでよい
+    const bool straight_drop = is_clear_above(bd, piece, goal.x, goal.y, goal.rot);
+
+    InputLayers layers(bd, piece, cost, !straight_drop, SPAWN_X, SPAWN_Y);
+    if (const auto hit = layers.find(goal.x, goal.y, goal.rot, straight_drop)) {
+        const auto tail = layers.path_to(*hit);
+        out.insert(out.end(), tail.begin(), tail.end());
+    }
+    out.push_back("hard"); // 最後に確定（到達不可でも）
     return out;
 }
 
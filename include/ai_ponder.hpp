@@ -0,0 +1,123 @@
+// ai_ponder.hpp — 入力送信中の先読み探索
+// ====================================================================
+// * start(step)  : step を置いた前提で、裏スレッドで SearchSession を進め
+//                  （play）、まだ見えていない次のミノの候補ごとに次の 1 段を
+//                  生成しておく（ponder）
+// * resolve(...) : 新しいミノが出た局面で呼ぶ。裏の先読みを止めて合流し、
+//                  予測と一致していれば先読み結果に新しい next を足して返す。
+//                  外れていれば（せり上がり・ズレ等）探索しなおす
+// * 裏スレッドが動いている間は session に触らないこと
+//   （reset したいときは先に cancel() する）
+// * 裏スレッドは最初の start で 1 本だけ作り、以後は条件変数で次の手を待つ
+//   （ミノごとに作り直さないので、スレッドローカルの着地キャッシュが残る）
+// ====================================================================
+#pragma once
+
+#include "ai_search.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ai {
+
+class Ponder {
+public:
+    static constexpr std::string_view ALL_PIECES = "IOTSZJL";
+
+    explicit Ponder(SearchSession& session) : session_(session) {}
+    ~Ponder()
+    {
+        cancel();
+        {
+            std::lock_guard lk(mutex_);
+            quit_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    Ponder(const Ponder&)            = delete;
+    Ponder& operator=(const Ponder&) = delete;
+
+    // step を確定した前提で先読みを始める。candidates は次に見えうるミノ
+    void start(const Step& step, std::string_view candidates = ALL_PIECES)
+    {
+        cancel();
+        stop_.store(false, std::memory_order_relaxed);
+        {
+            std::lock_guard lk(mutex_);
+            played_ = false;
+            job_.emplace(Job{step, std::vector<char>(candidates.begin(), candidates.end())});
+            busy_ = true;
+        }
+        if (!thread_.joinable()) thread_ = std::thread([this]{ worker(); });
+        cv_.notify_all();
+    }
+
+    // 新しいミノが出た局面で探索結果を受け取る
+    Node resolve(const Board& board, std::span<const char> queue, char hold)
+    {
+        cancel();
+        const bool played = std::exchange(played_, false);
+        if (!played) return session_.reset(board, queue, hold);
+        return session_.extend(board, queue, hold);
+    }
+
+    // 先読みを止めて裏スレッドの手が空くのを待つ（session は play 済みのことがある）
+    void cancel()
+    {
+        stop_.store(true, std::memory_order_relaxed);
+        wait();
+    }
+
+    // 先読みが全候補ぶん終わるまで待つ
+    void wait()
+    {
+        std::unique_lock lk(mutex_);
+        cv_.wait(lk, [&]{ return !busy_; });
+    }
+
+private:
+    struct Job {
+        Step              step;
+        std::vector<char> candidates;
+    };
+
+    void worker()
+    {
+        std::unique_lock lk(mutex_);
+        while (true) {
+            cv_.wait(lk, [&]{ return quit_ || job_.has_value(); });
+            if (quit_) return;
+            Job job = std::move(*job_);
+            job_.reset();
+            lk.unlock();
+
+            const bool played = session_.play(job.step);
+            if (played) session_.ponder(job.candidates, &stop_);
+
+            lk.lock();
+            played_ = played;
+            busy_   = false;
+            cv_.notify_all();
+        }
+    }
+
+    SearchSession&          session_;
+    std::thread             thread_;
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    std::optional<Job>      job_;
+    bool                    busy_   = false;   // job_ を渡してから終わるまで
+    bool                    quit_   = false;
+    std::atomic<bool>       stop_{false};
+    bool                    played_ = false;   // wait 後に読む
+};
+
+} // namespace ai
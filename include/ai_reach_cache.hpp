@@ -0,0 +1,92 @@
+// ai_reach_cache.hpp — binary_bfs（着地可能位置）のメモ化
+// ====================================================================
+// * key = (盤面, ミノ)。盤面ハッシュで直接マップし、盤面とミノを照合する
+//   （ハッシュ衝突で別盤面の着地位置を返すことはない）
+// * 容量は固定（2^LOG2_ENTRIES）。衝突したら上書きするだけの有界キャッシュ
+// * binary_bfs の結果は (盤面, ミノ) だけで決まるので、探索・ゲームを
+//   またいで使い回してよい（無効化は不要）
+// * スレッドセーフではない。並列展開ではワーカーごとに 1 つ持つこと
+// ====================================================================
+#pragma once
+
+#include "utils.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <algorithm>
+#include <type_traits>
+
+namespace ai {
+
+template<class Board, unsigned LOG2_ENTRIES = 12>
+class ReachCache {
+public:
+    using Land = reachability::static_vector<Board, 4>;
+
+    // 着地なし（size 0）のリスト
+    static Land empty_land()
+    {
+        std::array<Board, 4> none{};
+        Land ret{std::span{none}};
+        ret.used = 0;
+        return ret;
+    }
+
+    static constexpr std::size_t ENTRIES = std::size_t(1) << LOG2_ENTRIES;
+
+    ReachCache() : entries_(std::make_unique<Entry[]>(ENTRIES)) {}
+
+    // (board, piece) の着地位置。無ければ compute で求めて登録する
+    // * compute(std::span<Board, 4> out) -> 形状数 : エントリに直接書く（コピーなし）
+    // * compute() -> Land                         : 返した Land をエントリへ写す
+    // 返す参照は、このキャッシュの次の get() まで有効
+    template<class Compute>
+    const Land& get(const Board& board, char piece, Compute&& compute)
+    {
+        const std::uint64_t key = board.hash(std::uint8_t(piece));
+        Entry& e = entries_[key & (ENTRIES - 1)];
+        if (e.piece == piece && e.key == key && !(e.board != board)) {
+            ++hits_;
+            return e.land;
+        }
+        ++misses_;
+        if constexpr (std::is_invocable_v<Compute&, std::span<Board, 4>>) {
+            e.land.used = compute(std::span<Board, 4>{e.land.data});
+        } else {
+            const Land land = compute();
+            std::copy(land.data, land.data + land.size(), e.land.data);
+            e.land.used = land.size();
+        }
+        e.key   = key;
+        e.piece = piece;
+        e.board = board;
+        return e.land;
+    }
+
+    std::uint64_t hits()   const { return hits_; }
+    std::uint64_t misses() const { return misses_; }
+
+    void reset_stats() { hits_ = misses_ = 0; }
+
+    void clear()
+    {
+        for (std::size_t i = 0; i < ENTRIES; ++i) entries_[i].piece = 0;
+        reset_stats();
+    }
+
+private:
+    struct Entry {
+        Board         board{};
+        Land          land  = empty_land();   // used 以降は前の内容が残っていてよい
+        std::uint64_t key   = 0;
+        char          piece = 0; // 0 = 空
+    };
+
+    std::unique_ptr<Entry[]> entries_;
+    std::uint64_t            hits_   = 0;
+    std::uint64_t            misses_ = 0;
+};
+
+} // namespace ai
@@ -0,0 +1,283 @@
+// ai_runner.hpp — ボットのメインループ（状態読み → 探索 → 入力列 → キー送信）
+// ====================================================================
+// * run_bot(src, rc)   : GameStateSource から状態を読み、新しいミノが出るたびに
+//                        探索して入力を送る。src.finished() で戻る（実機は戻らない）
+// * 探索木はミノをまたいで使い回す（直前の手をハードドロップで確定できたときだけ）。
+//   入力を送っている間は Ponder が裏でその手の先を読んでおく
+// * stats を渡すとミノごとの遅延（読み・探索・経路・入力）を記録する
+// ====================================================================
+#pragma once
+
+#include "game_source.hpp"
+#include "ai_search.hpp"
+#include "ai_ponder.hpp"
+#include "ai_path.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cwchar>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ai {
+
+struct RunnerConf {
+    double                 searchBudgetMs = 0.0;   // 1 ミノあたりの探索時間上限（0 以下なら無制限 = depthMax まで）。
+                                                   // 越えたら完了済みの深さの最良手
+    std::optional<Weights> weights;                // 無ければ埋め込みの既定値
+    bool                   verbose = true;         // 計画・入力のログを stderr に出す
+};
+
+// 1 ミノ分の遅延 [ms]（状態を読み始めた時刻から）
+struct PieceLatency {
+    double readMs       = 0;   // 状態読み
+    double searchMs     = 0;   // 探索
+    double pathMs       = 0;   // 入力列の生成
+    double firstInputMs = 0;   // 最初のキーを押すまで
+    double totalMs      = 0;   // 最後のキーの反応まで
+};
+
+struct RunnerStats {
+    int pieces   = 0;   // 入力を送り切ったミノ（hard まで）
+    int desyncs  = 0;   // 入力中にピースが変わって再計画した回数
+    int failures = 0;   // 手が無い・入力列が空で hard だけ送った回数
+    std::vector<PieceLatency> latency;
+};
+
+namespace runner_detail {
+
+using Clock = std::chrono::steady_clock;
+
+inline double ms_between(Clock::time_point a, Clock::time_point b)
+{
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+inline bool token_to_key(const std::string& t, Key& k)
+{
+    if (t=="left")  { k = Key::Left;  return true; }
+    if (t=="right") { k = Key::Right; return true; }
+    if (t=="soft")  { k = Key::Soft;  return true; }
+    if (t=="cw")    { k = Key::Cw;    return true; }
+    if (t=="ccw")   { k = Key::Ccw;   return true; }
+    if (t=="hold")  { k = Key::Hold;  return true; }
+    if (t=="hard")  { k = Key::Hard;  return true; }
+    return false;
+}
+
+inline KeyResult press(GameStateSource& src, std::initializer_list<Key> keys)
+{
+    return src.press(std::span<const Key>(keys.begin(), keys.size()));
+}
+
+} // namespace runner_detail
+
+inline void run_bot(GameStateSource& src, const RunnerConf& rc = {}, RunnerStats* stats = nullptr)
+{
+    using namespace runner_detail;
+
+    SearchSession session;
+    Ponder        ponder(session);
+    bool          haveTree = false;
+    session.set_time_limit(rc.searchBudgetMs);
+    if (rc.weights) session.set_weights(*rc.weights);
+
+    // ランタイム状態
+    std::uint64_t lastPieceId     = 0;     // 前回の pieceId
+    std::uint64_t lastExecutedId  = 0;     // 入力を送ったピース
+    char          lastType        = 0;
+    bool          lastLocked      = false;
+    std::int32_t  prevFrame       = -1;
+    bool          warnedNoPiece   = false;
+
+    auto forget_piece = [&]{
+        lastPieceId = 0; lastExecutedId = 0;
+        lastType = 0; lastLocked = false;
+    };
+
+    GameState st;
+    while (!src.finished())
+    {
+        const auto t0 = Clock::now();
+        src.read(st);
+        const auto tRead = Clock::now();
+
+        if (!st.inMatch) {
+            src.idle(30);
+            prevFrame     = -1;
+            warnedNoPiece = false;
+            forget_piece();
+            haveTree      = false;
+            ponder.cancel();
+            continue;
+        }
+
+        const std::int32_t frame = st.frame;
+        if (frame == prevFrame) {
+            src.idle(1);
+            continue;
+        }
+        prevFrame = frame;
+
+        if (st.current == 0) {
+            if (!warnedNoPiece && rc.verbose) {
+                std::fwprintf(stderr, L"[WARN] F%04d: 落下ミノが検出できません\n", frame);
+            }
+            warnedNoPiece = true;
+            lastPieceId = 0;
+            continue;
+        }
+        warnedNoPiece = false;
+
+        // --- 新ミノ判定（id/type/locked のいずれか変化）---
+        bool idChanged   = (st.pieceId != 0 && st.pieceId != lastPieceId);
+        bool typeChanged = (lastType != 0 && st.current != lastType);
+        bool unlockSpawn = (lastLocked && !st.locked);
+        bool isNewPiece  = idChanged || typeChanged || unlockSpawn;
+
+        // 同一ピースに 2 度送らない
+        if (!isNewPiece && st.pieceId == lastExecutedId) {
+            lastType   = st.current;
+            lastLocked = st.locked;
+            continue;
+        }
+
+        // --- Board を構築 ---
+        Board board;
+        for (int y = 0; y < GameState::HEIGHT; ++y)
+            for (int x = 0; x < GameState::WIDTH; ++x)
+                if (st.rows[y] >> x & 1) board.set(x, y);
+
+        // --- 実キュー（current + next）---
+        std::vector<char> queue;
+        queue.push_back(st.current);
+        for (char c : st.next)
+            if (c) queue.push_back(c);
+
+        // --- 探索（読んだホールドを root の hold として渡す）---
+        // 直前の手の先読みと局面が一致すれば新しく見えた next の分だけ展開する
+        Node res;
+        if (haveTree) {
+            res = ponder.resolve(board, std::span(queue.data(), queue.size()), st.hold);
+        } else {
+            ponder.cancel();
+            res = session.reset(board, std::span(queue.data(), queue.size()), st.hold);
+        }
+        const auto tSearch = Clock::now();
+        haveTree = false;
+        if (res.path.empty()) {
+            if (rc.verbose) std::fwprintf(stderr, L"[WARN] F%04d: 探索失敗 (詰み?)\n", frame);
+            press(src, {Key::Hard}); // 苦し紛れ
+            if (stats) ++stats->failures;
+            // 次は新ミノ扱い
+            forget_piece();
+            continue;
+        }
+        const Step& mv = res.path[0];
+
+        // --- 入力トークン列 ---
+        auto tokens = build_input_path(board, mv, {});
+        const auto tPath = Clock::now();
+        if (tokens.empty()) {
+            press(src, {Key::Hard});
+            if (stats) ++stats->failures;
+            forget_piece();
+            continue;
+        }
+
+        // デバッグ
+        if (rc.verbose) {
+            std::fwprintf(stderr, L"-----------------------------\n");
+            std::fwprintf(stderr, L"[PLAN] F%04d piece=%lc usedHold=%lc dst=(%d,%d,r%d) tokens=%zu reused=%lc pondered=%lc\n",
+                          frame, wchar_t(st.current),
+                          mv.usedHold ? L'Y' : L'N',
+                          int(mv.x), int(mv.y), int(mv.rot),
+                          tokens.size(),
+                          session.reused() ? L'Y' : L'N',
+                          session.pondered() ? L'Y' : L'N');
+            for (const auto& t : tokens)
+                std::fwprintf(stderr, L"[DBG] F%04d token=%hs\n", frame, t.c_str());
+            std::fwprintf(stderr, L"-----------------------------\n");
+        }
+
+        auto isMove = [](const std::string& t){ return t=="left" || t=="right"; };
+        auto isRot  = [](const std::string& t){ return t=="cw"   || t=="ccw";   };
+
+        // 入力を送っている間にこの手の先を読んでおく（外れたら次の resolve で探索しなおす）
+        ponder.start(mv);
+
+        bool didHard  = false;
+        bool desynced = false; // ★ 途中でピースが変わったら中断
+        std::optional<Clock::time_point> tFirstInput;
+
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            const std::string& t = tokens[i];
+
+            Key k1{}, k2{};
+            if (!token_to_key(t, k1)) continue;
+            if (!tFirstInput) tFirstInput = Clock::now();
+
+            if (k1 == Key::Hold) { press(src, {Key::Hold}); continue; }
+            if (k1 == Key::Hard) { press(src, {Key::Hard}); didHard = true; break; }
+
+            // 移動＋回転は 1F 同時押し
+            bool combined = false;
+            if (i+1 < tokens.size() &&
+                ((isMove(t) && isRot(tokens[i+1])) || (isRot(t) && isMove(tokens[i+1])))) {
+                if (token_to_key(tokens[i+1], k2)) combined = true;
+            }
+
+            KeyResult r{};
+            if (combined) { r = press(src, {k1, k2}); ++i; }
+            else          { r = press(src, {k1}); }
+
+            if (rc.verbose) {
+                std::fprintf(stderr, "[DBG] F%04d: press token=%s combined=%d  ok=%d changed=%d lockedchg=%d\n",
+                             frame, t.c_str(), int(combined), int(r.ok), int(r.pieceChanged), int(r.lockedChanged));
+            }
+
+            // ★ ピースが切り替わってしまったら中断（ただし hold/hard の後は例外的に許容）
+            if (r.pieceChanged) {
+                desynced = true;
+                break;
+            }
+        }
+        const auto tDone = Clock::now();
+
+        // desync したら残りは送らず、次フレームで再計画（ズレ防止）
+        if (desynced && !didHard) {
+            if (rc.verbose) std::fwprintf(stderr, L"[DESYNC] F%04d: ピース切替を検知。残り入力を破棄して再計画します。\n", frame);
+            if (stats) ++stats->desyncs;
+            forget_piece();
+            continue;
+        }
+
+        if (didHard) {
+            if (stats) {
+                ++stats->pieces;
+                stats->latency.push_back({
+                    ms_between(t0, tRead), ms_between(tRead, tSearch), ms_between(tSearch, tPath),
+                    ms_between(t0, tFirstInput.value_or(tDone)), ms_between(t0, tDone)});
+            }
+            // 次のミノは先読みの続きから探索する
+            haveTree = true;
+            // 次は必ず新ミノ扱い（同一ポインタ再利用でも進む）
+            forget_piece();
+            continue;
+        }
+
+        // このピースには送信済み
+        lastExecutedId = st.pieceId;
+        // 次フレーム判定用
+        lastPieceId = st.pieceId;
+        lastType    = st.current;
+        lastLocked  = st.locked;
+    }
+    ponder.cancel();
+}
+
+} // namespace ai
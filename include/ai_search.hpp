@@ -11,13 +11,20 @@
 #include "block.hpp"
 #include "findfinalattachableminostates.hpp"
 #include "ai_evaluate.hpp"
+#include "ai_thread_pool.hpp"
+#include "ai_transposition.hpp"
+#include "ai_reach_cache.hpp"
+#include "piece_table.hpp"
+#include "timer.h"
 #include <array>
+#include <atomic>
 #include <vector>
 #include <algorithm>
-#include <unordered_set>
 #include <span>
+#include <type_traits>
 #include <cstdint>
 #include <iterator>
+#include <optional>
 #include <cassert>
 #ifdef AI_SEARCH_DEBUG
   #include <iostream>
@@ -34,6 +41,7 @@ namespace ai {
 using namespace reachability;
 using RS    = reachability::blocks::SRS;
 using Board = board_t<10,24>;
+using PieceTable = reachability::piece_table<Board, RS>;// (ミノ, 向き, x, y) → ミノの盤面
 
 // ----------------------- 探索パラメータ ---------------------
 struct Conf {
@@ -41,6 +49,15 @@ struct Conf {
     int beamInit     = 400;
     int beamMin      = 40;
     int shrinkStride = 3;
+
+    // 並列展開: frontier がこれ未満なら逐次、チャンク数はスレッド数×chunksPerThread
+    int parallelMinFrontier = 16;
+    int chunksPerThread     = 4;
+
+    // dedup テーブルの見積り: 親 1 つあたりの (dedup 後の) 子の数
+    int ttChildrenPerNode   = 32;
+    // true: ハッシュ一致時に盤面全体を照合する（衝突による誤 dedup なし・テーブルが 3 倍強）
+    bool exactDedup         = false;
 };
 static constexpr Conf conf;
 
@@ -66,112 +83,222 @@ struct Node {
 };
 
 // ----------------------- 状態キー生成 -----------------------
-inline uint64_t height_signature(const Board& b){
-    uint64_t sig = 0;
-    for(int x=0; x<10; ++x){
-        int y=23; while(y>=0 && !b.get(x,y)) --y;
-        sig |= uint64_t(y+1) << (x*5); // 5bit×10=50bit
-    }
-    return sig;
-}
-
+// 盤面全体のハッシュに hold / queuePos を seed として混ぜる
+// （高さシグネチャだけだと穴の位置が違う盤面が同一視されて候補が消える）
 inline uint64_t make_state_key(const Board& b, char hold, int pos){
-    uint64_t k = height_signature(b);
-    k ^= uint64_t(uint8_t(hold))     << 50;
-    k ^= uint64_t(uint8_t(pos & 31)) << 58; // 5bit
-    return k;
+    const uint64_t seed = (uint64_t(uint8_t(hold)) << 8) | uint64_t(uint8_t(pos & 31));
+    return b.hash(seed);
 }
 
-// ----------------------- WorkNode (内部) --------------------
-// path を持たず、親 index + 最後の一手だけ保持
-struct WorkNode {
-    // 盤面と評価
-    Board board{};
-    char  hold   = 0;
-    int   depth  = 0;
-    int   score  = 0;
+// 厳密 dedup 用: key 一致時に盤面 240bit + hold + queuePos まで照合する
+struct ExactState {
+    std::array<uint64_t, Board::num_of_under> lanes{};
+    char    hold = 0;
+    uint8_t pos  = 0;
+    bool operator==(const ExactState&) const = default;
+};
+using DedupVerify = std::conditional_t<conf.exactDedup, ExactState, NoVerify>;
+using DedupTable  = BasicTranspositionTable<DedupVerify>;
+
+template<class V = DedupVerify>
+inline V make_state_verify([[maybe_unused]] const Board& b,
+                           [[maybe_unused]] char hold,
+                           [[maybe_unused]] int pos){
+    if constexpr (std::is_same_v<V, ExactState>) return V{b.lanes(), hold, uint8_t(pos)};
+    else                                         return V{};
+}
 
-    // キュー
-    std::array<char,QUEUE_MAX> next{};
-    int queuePos = 0;
+// ----------------------- NodePool (内部) --------------------
+// 探索木のノードを列ごとの配列 (SoA) で保持する
+// * キューは探索ごとに 1 つだけ持ち、ノードは queuePos だけを持つ
+// * path は持たず、親 index + 最後の一手で復元
+// * frontier / ビーム選択はノード index の並べ替えで行う
+using Queue   = std::array<char,QUEUE_MAX>;
+using Columns = ColumnState<Board::width>;   // 差分評価用の列高さ・穴・凹凸・井戸
+
+struct NodePool {
+    std::vector<Board>   board;
+    std::vector<Columns> cols;
+    std::vector<int>     score;
+    std::vector<int>     parent;    // 親 index（root:-1）
+    std::vector<Step>    move;      // 親→自の手（root未使用）
+    std::vector<char>    hold;
+    std::vector<uint8_t> queuePos;
+    std::vector<uint8_t> depth;
+
+    int size() const { return static_cast<int>(score.size()); }
+
+    void reserve(std::size_t n){
+        board.reserve(n); cols.reserve(n); score.reserve(n); parent.reserve(n); move.reserve(n);
+        hold.reserve(n);  queuePos.reserve(n); depth.reserve(n);
+    }
+    void clear(){
+        board.clear(); cols.clear(); score.clear(); parent.clear(); move.clear();
+        hold.clear();  queuePos.clear(); depth.clear();
+    }
+    // 末尾を切り詰める（n <= size()）
+    void truncate(std::size_t n){
+        board.resize(n); cols.resize(n); score.resize(n); parent.resize(n); move.resize(n);
+        hold.resize(n);  queuePos.resize(n); depth.resize(n);
+    }
+    int push(const Board& b, const Columns& c, char h, int pos, int dep, int sc, int par, const Step& mv){
+        board.push_back(b);
+        cols.push_back(c);
+        score.push_back(sc);
+        parent.push_back(par);
+        move.push_back(mv);
+        hold.push_back(h);
+        queuePos.push_back(static_cast<uint8_t>(pos));
+        depth.push_back(static_cast<uint8_t>(dep));
+        return size() - 1;
+    }
+};
 
-    // 経路復元用
-    int  parent = -1;  // pool 内 親 index（root:-1）
-    int  id     = -1;  // pool 内 自 index
-    Step move{};       // 親→自の手（root未使用）
+// 生成済み・登録前の子（pool に入るまでの一時表現）
+struct ChildNode {
+    Board   board{};
+    Columns cols{};
+    char    hold     = 0;
+    uint8_t queuePos = 0;
+    int     score    = 0;
+    Step    move{};
 };
 
 // ----------------------- ランタイム生成 ---------------------
-// rot を実行時指定で Board を生成（テスト再生用）
+// rot を実行時指定で Board を生成（PieceTable を 1 回引くだけ。盤面に収まる位置で呼ぶこと）
 inline Board make_piece_board_runtime(int rot, char piece, uint8_t x, uint8_t y){
-    switch(rot){
-    case 0: return Board::template make_piece_board<0,RS>(x,y,piece);
-    case 1: return Board::template make_piece_board<1,RS>(x,y,piece);
-    case 2: return Board::template make_piece_board<2,RS>(x,y,piece);
-    default:return Board::template make_piece_board<3,RS>(x,y,piece);
+    return PieceTable::cells(piece, rot, x, y);
+}
+
+// ----------------------- 着地位置キャッシュ -----------------
+// 同じ盤面の親（hold / queuePos 違い、ライン消去後の合流）や hold 分岐で
+// 同じ (盤面, ミノ) の binary_bfs を何度も引くのでメモ化する。
+// 並列展開のワーカーからも呼ばれるのでスレッドごとに持つ
+using LandCache = ReachCache<Board, 12>;
+
+inline LandCache& land_cache(){
+    static thread_local LandCache cache;
+    return cache;
+}
+
+template<coord SPAWN>
+inline const LandCache::Land& landable(const Board& board, char piece){
+    // 結果はキャッシュのエントリを指す（次の landable まで有効。for_each_landing の中では呼ばない）
+    // 不正なミノ文字は BFS に渡さず「着地なし」
+    if(PieceTable::piece_id(piece) == PieceTable::INVALID_ID){
+        static const LandCache::Land none = LandCache::empty_land();
+        return none;
     }
+    return land_cache().get(board, piece, [&](std::span<Board, 4> out){
+        return search::binary_bfs_fast_into<RS,SPAWN>(board, piece, out);
+    });
 }
 
-// ----------------------- 子ノード展開 -----------------------
-inline void expand(const WorkNode& parent,
-                   std::vector<WorkNode>& out,
-                   std::unordered_set<uint64_t>& dedup,
-                   std::vector<WorkNode>& pool)
+// ----------------------- 着地位置の列挙 ---------------------
+// land は形状ごと（O:1, S/Z/I:2, 他:4）にしか入っていないので、形状数だけ回す。
+// 形状 s は向き s で置ける（mino_index[s] == s）ので向き s の PieceTable がそのまま使える
+template<const auto& Block>
+constexpr bool shape_index_is_rotation(){
+    for(int s=0; s<Block.SHAPES; ++s) if(Block.mino_index[s] != s) return false;
+    return true;
+}
+static_assert(shape_index_is_rotation<RS::T>() && shape_index_is_rotation<RS::S>()
+           && shape_index_is_rotation<RS::Z>() && shape_index_is_rotation<RS::J>()
+           && shape_index_is_rotation<RS::L>() && shape_index_is_rotation<RS::O>()
+           && shape_index_is_rotation<RS::I>());
+
+// f(rot, x, y, ミノ盤面) を物理的に異なる置き方ごとに 1 回ずつ呼ぶ（不正なミノ文字なら呼ばない）
+template<class F>
+inline void for_each_landing(const LandCache::Land& land, char piece, F&& f){
+    if(PieceTable::piece_id(piece) == PieceTable::INVALID_ID) return;
+    static_for<4>([&](auto rc){
+        constexpr std::size_t ROT = rc;
+        if(ROT >= land.size()) return;
+        const std::size_t base = PieceTable::index(PieceTable::piece_id(piece), ROT, 0, 0);
+        land[ROT].list_bits_256([&](uint8_t x,uint8_t y){
+            f(uint8_t(ROT), x, y, PieceTable::cells_at(base + std::size_t(y) * Board::width + x));
+        });
+    });
+}
+
+// ----------------------- dedup 順序 -------------------------
+// 逐次展開で子が生成される順番。上位から (深さ, frontier 内の親 index, 親内の子 index)
+// 並列展開では TranspositionTable::claim がこの最小値を取り合う
+inline uint64_t child_order(int depth, int parentIdx, int childIdx){
+    return (uint64_t(depth) << 32) | (uint64_t(parentIdx) << 11) | uint64_t(childIdx);
+}
+
+// ----------------------- 評価 -------------------------------
+// weights が nullptr なら DEFAULT_WEIGHTS を埋め込んだ版、あれば実行時の係数で評価
+inline int evaluate_node(const Columns& cols, int cleared, const Weights* weights)
+{
+    if(weights) return ai::evaluate<Board::width, Board::height>(cols, cleared, *weights);
+    return ai::evaluate<Board::width, Board::height>(cols, cleared);
+}
+
+// ----------------------- 子ノード生成 -----------------------
+// parent から作れる子を生成順に作り、
+//   accept(key, order, verify) が true を返したものだけ評価して emit(ChildNode&, key, order, verify) へ渡す
+// （dedup を評価より先に行い、重複子の evaluate を省く）
+template<class Accept, class Emit>
+inline void generate_children(const NodePool& pool, const Queue& queue,
+                              int parentId, int parentIdx, const Weights* weights,
+                              Accept&& accept, Emit&& emit)
 {
     constexpr coord SPAWN{4,20};
+    int childIdx = 0;
+
+    // 逐次展開では emit 中に pool が伸びる（再確保される）ので親は値で持つ
+    const Board   board    = pool.board[parentId];
+    const Columns cols     = pool.cols[parentId];
+    const char    hold     = pool.hold[parentId];
+    const int     queuePos = pool.queuePos[parentId];
+    const int     depth    = pool.depth[parentId];
 
-    auto push_child = [&](Board brd, char hold, int newPos, Step st){
+    auto push_child = [&](const Board& blk, char newHold, int newPos, Step st){
         if(newPos >= QUEUE_MAX){ AI_DBG("[Skip] newPos OOB="<<newPos); return; }
 
+        Board brd = board | blk;
         int cleared = brd.clear_full_lines();
 
-        WorkNode ch{};
+        const uint64_t    key    = make_state_key(brd, newHold, newPos);
+        const uint64_t    order  = child_order(depth + 1, parentIdx, childIdx++);
+        const DedupVerify verify = make_state_verify(brd, newHold, newPos);
+        if(!accept(key, order, verify)) return;
+
+        // ライン消去が無ければ親の列状態をミノの列だけ差分更新、あれば作り直す
+        ChildNode ch{};
         ch.board    = brd;
-        ch.hold     = hold;
-        ch.depth    = parent.depth + 1;
-        ch.score    = ai::evaluate(ch.board, cleared);
-        ch.next     = parent.next;
-        ch.queuePos = newPos;
+        if(cleared == 0){ ch.cols = cols; place_update(ch.cols, blk); }
+        else            { ch.cols = column_state(brd); }
+        ch.hold     = newHold;
+        ch.queuePos = static_cast<uint8_t>(newPos);
+        ch.score    = evaluate_node(ch.cols, cleared, weights);
 
-        ch.parent   = parent.id;
         st.cleared    = cleared;
         st.scoreAfter = ch.score;
         ch.move     = st;
 
-        uint64_t key = make_state_key(ch.board, ch.hold, ch.queuePos);
-        if(dedup.insert(key).second){
-            ch.id = static_cast<int>(pool.size());
-            pool.push_back(ch);
-            out.push_back(ch);
-            AI_DBG("  [+] push depth="<<ch.depth<<" pos="<<newPos<<" score="<<ch.score);
-        }
+        emit(ch, key, order, verify);
     };
 
     // --- キュー取得 ---
-    if(parent.queuePos >= QUEUE_MAX){ AI_DBG("[Stop] parent.queuePos OOB"); return; }
-    const char cur = parent.next[parent.queuePos];
-    if(cur == 0){ AI_DBG("[Stop] queue empty at pos="<<parent.queuePos); return; }
+    if(queuePos >= QUEUE_MAX){ AI_DBG("[Stop] queuePos OOB"); return; }
+    const char cur = queue[queuePos];
+    if(cur == 0){ AI_DBG("[Stop] queue empty at pos="<<queuePos); return; }
 
-    AI_DBG("[Expand] depth="<<parent.depth
+    AI_DBG("[Expand] depth="<<depth
            <<" cur="<<cur
-           <<" hold="<<int(parent.hold));
+           <<" hold="<<int(hold));
 
     // ========================================================
     // (1) 通常配置: cur をそのまま置く
     // ========================================================
     {
-        const int newPos = parent.queuePos + 1; // キュー1個消費
-        auto land = search::binary_bfs<RS,SPAWN>(parent.board, cur);
-        static_for<4>([&](auto rc){
-            constexpr std::size_t ROT = rc;
-            land[ROT].list_bits_256([&](uint8_t x,uint8_t y){
-                Board blk = Board::template make_piece_board<ROT,RS>(x,y,cur);
-                // #ifdef AI_SEARCH_DEBUG
-                //   std::cerr << to_string(parent.board | blk) << "\n";
-                // #endif
-                Step st{cur,false,(uint8_t)ROT,x,y,0,0};
-                push_child(parent.board | blk, parent.hold, newPos, st);
-            });
+        const int newPos = queuePos + 1; // キュー1個消費
+        for_each_landing(landable<SPAWN>(board, cur), cur, [&](uint8_t rot, uint8_t x, uint8_t y, const Board& blk){
+            Step st{cur,false,rot,x,y,0,0};
+            push_child(blk, hold, newPos, st);
         });
     }
 
@@ -182,116 +309,474 @@ inline void expand(const WorkNode& parent,
     // ========================================================
     {
         char newHold = cur;
-        if(parent.hold == 0){
+        if(hold == 0){
             // 初回ホールド
-            int idx2 = parent.queuePos + 1;
+            int idx2 = queuePos + 1;
             if(idx2 >= QUEUE_MAX){ AI_DBG("[Hold] idx2 OOB="<<idx2); goto HOLD_END; }
-            char use = parent.next[idx2];
+            char use = queue[idx2];
             if(use == 0){ AI_DBG("[Hold] queue empty idx2="<<idx2); goto HOLD_END; }
 
-            auto landH = search::binary_bfs<RS,SPAWN>(parent.board, use);
-            static_for<4>([&](auto rc){
-                constexpr std::size_t ROT = rc;
-                landH[ROT].list_bits_256([&](uint8_t x,uint8_t y){
-                    Board blk = Board::template make_piece_board<ROT,RS>(x,y,use);
-                    // #ifdef AI_SEARCH_DEBUG
-                    //   std::cerr << to_string(parent.board | blk) << "\n";
-                    //   std::cerr << "Hold(new)=" << newHold << " Use=" << use << "\n";
-                    // #endif
-                    Step st{use,true,(uint8_t)ROT,x,y,0,0};
-                    push_child(parent.board | blk, newHold, parent.queuePos + 2, st);
-                });
+            for_each_landing(landable<SPAWN>(board, use), use, [&](uint8_t rot, uint8_t x, uint8_t y, const Board& blk){
+                Step st{use,true,rot,x,y,0,0};
+                push_child(blk, newHold, queuePos + 2, st);
             });
         }else{
             // 交換ホールド
-            char use = parent.hold;
-            auto landH = search::binary_bfs<RS,SPAWN>(parent.board, use);
-            static_for<4>([&](auto rc){
-                constexpr std::size_t ROT = rc;
-                landH[ROT].list_bits_256([&](uint8_t x,uint8_t y){
-                    Board blk = Board::template make_piece_board<ROT,RS>(x,y,use);
-                    // #ifdef AI_SEARCH_DEBUG
-                    //   std::cerr << to_string(parent.board | blk) << "\n";
-                    //   std::cerr << "Hold(sw)=" << newHold << " Use=" << use << "\n";
-                    // #endif
-                    Step st{use,true,(uint8_t)ROT,x,y,0,0};
-                    push_child(parent.board | blk, newHold, parent.queuePos + 1, st);
-                });
+            char use = hold;
+            for_each_landing(landable<SPAWN>(board, use), use, [&](uint8_t rot, uint8_t x, uint8_t y, const Board& blk){
+                Step st{use,true,rot,x,y,0,0};
+                push_child(blk, newHold, queuePos + 1, st);
             });
         }
     }
 HOLD_END:;
 }
 
+// ----------------------- 子ノード登録 -----------------------
+// dedup を通った子を pool に積み、index を out に追加
+inline void commit_child(NodePool& pool, int parentId, const ChildNode& ch, std::vector<int>& out)
+{
+    const int id = pool.push(ch.board, ch.cols, ch.hold, ch.queuePos, pool.depth[parentId] + 1,
+                             ch.score, parentId, ch.move);
+    out.push_back(id);
+    AI_DBG("  [+] push depth="<<int(pool.depth[id])<<" pos="<<int(ch.queuePos)<<" score="<<ch.score);
+}
+
+// ----------------------- 子ノード展開 -----------------------
+inline void expand(NodePool& pool,
+                   const Queue& queue,
+                   int parentId,
+                   int parentIdx,
+                   std::vector<int>& out,
+                   DedupTable& dedup,
+                   const Weights* weights = nullptr)
+{
+    generate_children(pool, queue, parentId, parentIdx, weights,
+        [&](uint64_t key, uint64_t order, const DedupVerify& v){ return dedup.insert(key, order, v); },
+        [&](ChildNode& ch, uint64_t, uint64_t, const DedupVerify&){ commit_child(pool, parentId, ch, out); });
+}
+
+// ----------------------- 並列展開 ---------------------------
+// 生成済みで登録待ちの子
+struct PendingChild {
+    ChildNode node;
+    int       parent = -1;
+    uint64_t  key    = 0;
+    uint64_t  order  = 0;
+    [[no_unique_address]] DedupVerify verify{};
+};
+
+// frontier を連続チャンクに分けてワーカーで子を生成する。
+// dedup は共有テーブルへの claim（ロックフリー）で最小 order を取り合い、
+// 生成後にチャンク順で「自分が最小 order の持ち主か」を確かめて登録するので
+// 逐次版 expand と同一の結果になる（ワーカー中は pool を読むだけ）
+// timer を渡すと親 1 つごとに期限を確認し、切れたら何も登録せず false を返す
+inline bool expand_parallel(NodePool& pool,
+                            const Queue& queue,
+                            const std::vector<int>& frontier,
+                            std::vector<int>& out,
+                            DedupTable& dedup,
+                            ThreadPool& workers,
+                            std::vector<std::vector<PendingChild>>& chunkBuf,
+                            const ChronoTimer* timer = nullptr,
+                            const Weights* weights = nullptr)
+{
+    const int n       = static_cast<int>(frontier.size());
+    const int nChunks = std::min<int>(n, static_cast<int>(workers.size()) * conf.chunksPerThread);
+    if(static_cast<int>(chunkBuf.size()) < nChunks) chunkBuf.resize(nChunks);
+
+    // claim はテーブルを拡張できないので先に余裕を持たせておく
+    dedup.reserve(std::size_t(n) * conf.ttChildrenPerNode * 4);
+
+    std::atomic<bool> expired{false};
+    workers.parallel_for(nChunks, [&](int c, unsigned){
+        auto& buf = chunkBuf[c];
+        buf.clear();
+        const int lo = static_cast<int>(int64_t(n) *  c      / nChunks);
+        const int hi = static_cast<int>(int64_t(n) * (c + 1) / nChunks);
+        for(int i = lo; i < hi; ++i){
+            if(expired.load(std::memory_order_relaxed)) return;
+            if(timer && timer->TimeOver()){ expired.store(true, std::memory_order_relaxed); return; }
+            const int pid = frontier[i];
+            generate_children(pool, queue, pid, i, weights,
+                [&](uint64_t key, uint64_t order, const DedupVerify& v){ return dedup.claim(key, order, v); },
+                [&](ChildNode& ch, uint64_t key, uint64_t order, const DedupVerify& v){
+                    buf.push_back({ch, pid, key, order, v});
+                });
+        }
+    });
+
+    if(expired.load(std::memory_order_relaxed)) return false;
+
+    for(int c = 0; c < nChunks; ++c)
+        for(const auto& pc : chunkBuf[c]){
+            const uint64_t o = dedup.owner(pc.key, pc.verify);
+            if(o == pc.order || o == DedupTable::NO_ORDER) commit_child(pool, pc.parent, pc.node, out);
+        }
+    return true;
+}
+
 // ----------------------- ビーム幅計算 -----------------------
-inline int beam_width(int depth){
+constexpr int beam_width(int depth){
     int w = conf.beamInit >> (depth / conf.shrinkStride);
     return std::max(w, conf.beamMin);
 }
 
-// ----------------------- メイン探索 ------------------------
-inline Node search(Board init, std::span<const char> queue)
-{
-    // root 設定
-    WorkNode root{};
-    root.board    = init;
-    root.hold     = 0;
-    root.depth    = 0;
-    root.score    = ai::evaluate(init,0);
-    std::fill(root.next.begin(), root.next.end(), 0);
-    std::copy_n(queue.begin(), std::min<std::size_t>(QUEUE_MAX, queue.size()), root.next.begin());
-    root.queuePos = 0;
-    root.parent   = -1;
-    root.id       = 0;
-
-    std::vector<WorkNode> pool;
-    pool.reserve(1<<16);
-    pool.push_back(root);
-
-    std::vector<WorkNode> frontier{root};
-    std::vector<WorkNode> next;
-    std::unordered_set<uint64_t> dedup;
-    dedup.reserve(1<<16);
-    dedup.insert(make_state_key(root.board, root.hold, root.queuePos));
-
-    AI_DBG("[Search] start frontier=1 depthMax="<<conf.depthMax);
-
-    // 深さループ
-    for(int d=0; d<conf.depthMax; ++d){
-        next.clear();
-        AI_DBG("--- depth="<<d<<" frontier="<<frontier.size());
-        for(const auto& n: frontier) expand(n,next,dedup,pool);
-        if(next.empty()){ AI_DBG("[Stop] next empty at depth="<<d); break; }
+// dedup テーブルの初期サイズ見積り（ビーム設定から）
+constexpr std::size_t expected_tt_entries(){
+    std::size_t parents = 1;
+    for(int d=1; d<conf.depthMax; ++d) parents += beam_width(d);
+    return parents * conf.ttChildrenPerNode;
+}
+
+// ----------------------- 探索セッション --------------------
+// 連続するミノの探索で木を使い回す
+// * reset()   : 局面から探索しなおす（root の hold も指定できる）
+// * advance() : 直前の最善手を確定した後の局面を渡す。root の子のうち
+//               その手の子を新しい root にし、部分木（評価済み）を残したまま
+//               新しく見えた next の分だけ深さを伸ばす。
+//               盤面・hold・キューが木と食い違えば reset() にフォールバック
+// * 再利用時の各深さの候補は「選んだ子の子孫」に限られる（全体のビームより狭い）
+// * set_time_limit() で 1 回の reset / advance の時間上限を決めると anytime 探索になる。
+//   1 手ずつ深くし、期限が切れた深さは途中の子を捨てて、最後に完了した深さの最良を返す
+//   （root からの 1 手目だけは期限を過ぎても完了させる＝必ず手を返す）
+class SearchSession {
+public:
+    explicit SearchSession(ThreadPool* workers = nullptr) : workers_(workers) {}
+
+    void set_workers(ThreadPool* workers){ workers_ = workers; }
+
+    // 1 回の reset / advance に使える時間 [ms]（0 以下なら無制限 = depthMax まで）
+    void set_time_limit(double ms){ timeLimitMs_ = ms; }
+
+    // 評価係数を実行時の値にする / 埋め込みの DEFAULT_WEIGHTS に戻す。
+    // 既存の木のスコアは作り直さないので reset() の前に呼ぶこと
+    void set_weights(const Weights& w){ weights_ = w; }
+    void clear_weights(){ weights_.reset(); }
+
+    Node reset(const Board& board, std::span<const char> queue, char hold = 0)
+    {
+        start_timer();
+        return rebuild(board, queue, hold);
+    }
+
+    Node advance(const Step& step, const Board& board, std::span<const char> queue, char hold)
+    {
+        start_timer();
+        if(!play(step)) return rebuild(board, queue, hold);
+        return resume(board, queue, hold);
+    }
 
+    // ---- 先読み (ponder) 用 -----------------------------------
+    // 1) play(step)       : 手を確定したことにして root を進める（実局面との照合はしない）
+    // 2) ponder(候補)     : 次に見えるミノの候補ごとに frontier の次の 1 段を生成しておく
+    // 3) extend(実局面)   : root と照合し、新しく見えた next の分だけ伸ばす。
+    //                       見えたミノが 1 つで先読み済みなら、その子を逐次展開と同じ順で
+    //                       dedup → 登録するので、advance() と同じ結果になる
+    // 2) は別スレッドから呼んでよい（その間 1) 3) や reset を呼ばないこと）
+    bool play(const Step& step)
+    {
+        spec_.clear();
+        const int child = find_root_child(step);
+        if(child < 0) return false;
+        reroot(child);
+        return !frontier_.empty();
+    }
+
+    void ponder(std::span<const char> candidates, const std::atomic<bool>* cancel = nullptr)
+    {
+        spec_.clear();
+        if(depth_ >= conf.depthMax || queueLen_ >= QUEUE_MAX) return;
+        for(char p : candidates){
+            Speculative sp;
+            sp.piece = p;
+            Queue q = queue_;
+            q[queueLen_] = p;
+            for(int i=0; i<static_cast<int>(frontier_.size()); ++i){
+                if(cancel && cancel->load(std::memory_order_relaxed)) return; // 途中の候補は使わない
+                const int pid = frontier_[i];
+                generate_children(pool_, q, pid, i, weights(),
+                    [](uint64_t, uint64_t, const DedupVerify&){ return true; },
+                    [&](ChildNode& ch, uint64_t key, uint64_t order, const DedupVerify& v){
+                        sp.children.push_back({ch, pid, key, order, v});
+                    });
+            }
+            spec_.push_back(std::move(sp));
+        }
+    }
+
+    Node extend(const Board& board, std::span<const char> queue, char hold)
+    {
+        start_timer();
+        return resume(board, queue, hold);
+    }
+
+    // 直前の reset / advance / extend で木を再利用できたか・先読みした 1 段を使えたか
+    bool reused()   const { return reused_; }
+    bool pondered() const { return pondered_; }
+
+    // 直前の reset / advance が時間切れで depthMax より手前で止まったか
+    bool timed_out() const { return timedOut_; }
+
+    Node best() const
+    {
+        // 最良ノード決定
+        const int b = *std::max_element(frontier_.begin(), frontier_.end(),
+            [&](int x,int y){ return pool_.score[x] < pool_.score[y]; });
+
+        AI_DBG("[Search] best depth="<<int(pool_.depth[b])<<" score="<<pool_.score[b]);
+
+        // パス復元
+        std::vector<Step> path;
+        for(int id = b; id != root_; id = pool_.parent[id]) path.push_back(pool_.move[id]); // rootは手無し
+        std::reverse(path.begin(), path.end());
+
+        Node ret;
+        ret.board = pool_.board[b];
+        ret.hold  = pool_.hold[b];
+        ret.depth = pool_.depth[b];
+        ret.score = pool_.score[b];
+        ret.path  = std::move(path);
+        return ret;
+    }
+
+private:
+    // ponder() で先に生成した「次のミノが piece だった場合」の子（生成順・dedup 前）
+    struct Speculative {
+        char                      piece = 0;
+        std::vector<PendingChild> children;
+    };
+
+    const Weights* weights() const { return weights_ ? &*weights_ : nullptr; }
+
+    void start_timer()
+    {
+        timer_.SetTimer(timeLimitMs_);
+        timer_.Start();
+    }
+
+    Node rebuild(const Board& board, std::span<const char> queue, char hold)
+    {
+        reused_   = false;
+        pondered_ = false;
+        spec_.clear();
+        set_queue(queue);
+
+        pool_.clear();
+        pool_.reserve(1<<16);
+        const Columns cols = column_state(board);
+        root_ = pool_.push(board, cols, hold, 0, 0, evaluate_node(cols, 0, weights()), -1, Step{});
+
+        frontier_.assign(1, root_);
+        depth_ = 0;
+        dedup_.reset(expected_tt_entries());
+        dedup_.insert(make_state_key(board, hold, 0), child_order(0,0,0), make_state_verify(board, hold, 0));
+        dedupStale_ = false;
+
+        AI_DBG("[Search] start frontier=1 depthMax="<<conf.depthMax);
+        grow();
+        return best();
+    }
+
+    // root が実局面と一致していれば、新しく見えた next の分だけ伸ばす
+    Node resume(const Board& board, std::span<const char> queue, char hold)
+    {
+        if(frontier_.empty() || !consistent(root_, board, queue, hold)){
+            AI_DBG("[Session] cannot reuse tree -> reset");
+            return rebuild(board, queue, hold);
+        }
+        reused_ = true;
+        if(dedupStale_) rebuild_dedup();
+
+        // 見えたミノが 1 つだけなら先読み結果が使える（2 つ以上だと初回ホールドの子が増える）
+        const Speculative* sp = nullptr;
+        if(queueLen_ < QUEUE_MAX && queue.size() == std::size_t(queueLen_) + 1)
+            for(const auto& c : spec_) if(c.piece == queue[queueLen_]) sp = &c;
+
+        pondered_ = sp != nullptr;
+        set_queue(queue);
+        AI_DBG("[Session] reuse nodes="<<pool_.size()<<" frontier="<<frontier_.size()<<" depth="<<depth_
+               <<" pondered="<<(sp != nullptr));
+        if(sp){
+            next_.clear();
+            for(const auto& pc : sp->children)
+                if(dedup_.insert(pc.key, pc.order, pc.verify)) commit_child(pool_, pc.parent, pc.node, next_);
+            if(!next_.empty()) select_beam(depth_);
+        }
+        spec_.clear();
+        grow();
+        return best();
+    }
+
+    void set_queue(std::span<const char> queue)
+    {
+        queue_.fill(0);
+        queueLen_ = static_cast<int>(std::min<std::size_t>(QUEUE_MAX, queue.size()));
+        std::copy_n(queue.begin(), queueLen_, queue_.begin());
+    }
+
+    // 深さループ: frontier_ から depthMax まで（キューが尽きたら終了）
+    void grow()
+    {
+        timedOut_ = false;
+
+        for(int d=depth_; d<conf.depthMax; ++d){
+            next_.clear();
+            AI_DBG("--- depth="<<d<<" frontier="<<frontier_.size());
+
+            // 期限は親の展開ごとに確認。root の展開 (d==0) だけは打ち切らない
+            const ChronoTimer* timer = (timeLimitMs_ > 0 && d > 0) ? &timer_ : nullptr;
+            const int mark = pool_.size();
+            bool done = true;
+            if(workers_ && workers_->size() > 1
+               && static_cast<int>(frontier_.size()) >= conf.parallelMinFrontier)
+                done = expand_parallel(pool_,queue_,frontier_,next_,dedup_,*workers_,chunkBuf_,timer,weights());
+            else
+                for(int i=0; i<static_cast<int>(frontier_.size()); ++i){
+                    if(timer && timer->TimeOver()){ done = false; break; }
+                    expand(pool_,queue_,frontier_[i],i,next_,dedup_,weights());
+                }
+            if(!done){
+                // 途中の深さは捨てる（dedup に残ったキーは次に伸ばす前に作り直す）
+                AI_DBG("[Stop] time limit at depth="<<d<<" elapsed="<<timer_.Elapsed()<<"ms");
+                pool_.truncate(mark);
+                timedOut_   = true;
+                dedupStale_ = true;
+                break;
+            }
+            if(next_.empty()){ AI_DBG("[Stop] next empty at depth="<<d); break; }
+            select_beam(d);
+        }
+    }
+
+    // 深さ d の frontier_ から作った next_ をビーム幅に絞って次の frontier_ にする
+    void select_beam(int d)
+    {
+        auto by_score = [&](int a, int b){ return pool_.score[a] > pool_.score[b]; };
         int bw = beam_width(d+1);
-        std::partial_sort(next.begin(),
-                          next.begin()+std::min<int>(bw,next.size()),
-                          next.end(),
-                          [](const WorkNode& a,const WorkNode& b){return a.score>b.score;});
-        if(static_cast<int>(next.size())>bw) next.resize(bw);
-        frontier.swap(next);
+        std::partial_sort(next_.begin(),
+                          next_.begin()+std::min<int>(bw,next_.size()),
+                          next_.end(),
+                          by_score);
+        if(static_cast<int>(next_.size())>bw) next_.resize(bw);
+        frontier_.swap(next_);
+        depth_ = d+1;
     }
 
-    // 最良ノード決定
-    const WorkNode& best = *std::max_element(frontier.begin(), frontier.end(),
-        [](const WorkNode& a,const WorkNode& b){ return a.score < b.score; });
+    int find_root_child(const Step& st) const
+    {
+        for(int id = root_+1; id < pool_.size() && pool_.depth[id] == 1; ++id){
+            const Step& m = pool_.move[id];
+            if(pool_.parent[id] == root_ && m.piece == st.piece && m.usedHold == st.usedHold
+               && m.rot == st.rot && m.x == st.x && m.y == st.y) return id;
+        }
+        return -1;
+    }
+
+    // 実際の局面がノード id と一致するか（せり上がり・ズレ等を検出）
+    bool consistent(int id, const Board& board, std::span<const char> queue, char hold) const
+    {
+        if(pool_.board[id] != board || pool_.hold[id] != hold) return false;
+        const int shift = pool_.queuePos[id];
+        const int known = std::min<int>(queueLen_ - shift, static_cast<int>(queue.size()));
+        for(int i=0; i<known; ++i) if(queue_[shift+i] != queue[i]) return false;
+        return true;
+    }
+
+    // child を新しい root にして、その子孫だけを詰め直す
+    // pool は親が必ず子より前にあるので 1 パスで子孫判定できる
+    void reroot(int child)
+    {
+        const int shift = pool_.queuePos[child];
+        const int n     = pool_.size();
+        remap_.assign(n, -1);
+        remap_[child] = 0;
+
+        int w = 0;
+        for(int id = child; id < n; ++id){
+            if(id != child && (pool_.parent[id] < child || remap_[pool_.parent[id]] < 0)) continue;
+            remap_[id]         = w;
+            pool_.board[w]     = pool_.board[id];
+            pool_.score[w]     = pool_.score[id];
+            pool_.parent[w]    = id == child ? -1 : remap_[pool_.parent[id]];
+            pool_.move[w]      = pool_.move[id];
+            pool_.cols[w]      = pool_.cols[id];
+            pool_.hold[w]      = pool_.hold[id];
+            pool_.queuePos[w]  = static_cast<uint8_t>(pool_.queuePos[id] - shift);
+            pool_.depth[w]     = static_cast<uint8_t>(pool_.depth[id] - 1);
+            ++w;
+        }
+        pool_.truncate(w);
+        root_ = 0;
+
+        std::erase_if(frontier_, [&](int& id){ id = remap_[id]; return id < 0; });
+        depth_ = std::max(0, depth_ - 1);
+
+        // キューも root に合わせて詰める
+        std::copy(queue_.begin() + shift, queue_.end(), queue_.begin());
+        std::fill(queue_.end() - shift, queue_.end(), 0);
+        queueLen_ = std::max(0, queueLen_ - shift);
 
-    AI_DBG("[Search] best depth="<<best.depth<<" score="<<best.score);
+        // queuePos がずれたのでキーを作り直す
+        rebuild_dedup();
+    }
 
-    // パス復元
-    std::vector<Step> path;
-    for(int id = best.id; id != -1; id = pool[id].parent){
-        if(id != 0) path.push_back(pool[id].move); // rootは手無し
+    // pool の全ノードで dedup を作り直す（残すノードは新しい子より小さい order）
+    void rebuild_dedup()
+    {
+        dedup_.reset(expected_tt_entries());
+        for(int id = 0; id < pool_.size(); ++id){
+            dedup_.insert(make_state_key(pool_.board[id], pool_.hold[id], pool_.queuePos[id]),
+                          child_order(pool_.depth[id],0,0),
+                          make_state_verify(pool_.board[id], pool_.hold[id], pool_.queuePos[id]));
+        }
+        dedupStale_ = false;
     }
-    std::reverse(path.begin(), path.end());
-
-    Node ret;
-    ret.board = best.board;
-    ret.hold  = best.hold;
-    ret.depth = best.depth;
-    ret.score = best.score;
-    ret.path  = std::move(path);
-    return ret;
+
+    ThreadPool*      workers_  = nullptr;
+    NodePool         pool_;
+    DedupTable       dedup_;
+    Queue            queue_{};
+    int              queueLen_ = 0;
+    int              root_     = 0;
+    int              depth_    = 0;     // frontier_ の深さ
+    bool             reused_   = false;
+    bool             pondered_ = false;
+    bool             timedOut_ = false;
+    bool             dedupStale_ = false; // 打ち切った深さのキーが残っている
+    double           timeLimitMs_ = 0;
+    std::optional<Weights> weights_;    // 無ければ DEFAULT_WEIGHTS（コンパイル時）
+    ChronoTimer      timer_;
+    std::vector<int> frontier_;
+    std::vector<int> next_;
+    std::vector<int> remap_;
+    std::vector<Speculative> spec_;
+    std::vector<std::vector<PendingChild>> chunkBuf_;
+};
+
+// ----------------------- メイン探索 ------------------------
+// セッションはスレッドごとに使い回す（容量は保持したまま clear / 世代更新）
+inline SearchSession& thread_session(){
+    static thread_local SearchSession session;
+    return session;
+}
+
+// workers を渡すと frontier の展開をスレッドプールで並列化する（結果は逐次と同一）
+inline Node search(Board init, std::span<const char> queue, ThreadPool* workers = nullptr)
+{
+    SearchSession& session = thread_session();
+    session.set_workers(workers);
+    session.set_time_limit(0);
+    return session.reset(init, queue);
+}
+
+// anytime 版: timeLimitMs 以内に完了した最も深い深さの最良を返す
+inline Node search_for(Board init, std::span<const char> queue, double timeLimitMs, ThreadPool* workers = nullptr)
+{
+    SearchSession& session = thread_session();
+    session.set_workers(workers);
+    session.set_time_limit(timeLimitMs);
+    return session.reset(init, queue);
 }
 
 } // namespace ai
@@ -0,0 +1,126 @@
+// ai_sim.hpp — ゲーム画面なしの自己対戦シミュレータ（係数チューニング用）
+// ====================================================================
+// * play_game()     : SevenBag(seed) のミノ列で 1 ゲーム遊ぶ。
+//                     cur + preview 個の窓で探索し、最善手の 1 手目を置いて進める
+//                     （木は SearchSession::advance で使い回す）
+// * SelfPlay        : 係数 1 組を seeds の全ゲームで遊ばせ、平均の fitness を返す。
+//                     ゲーム単位で ThreadPool に配り、ワーカーごとに SearchSession を持つ
+//                     （着地キャッシュ等はスレッドローカルなのでワーカー間で共有しない）
+// * 結果は (seed, 係数, GameConf) だけで決まる。
+//   ただし timeLimitMs > 0 の anytime 探索にすると負荷で結果が揺れる
+// * 火力は消去数だけから数える（T-spin・REN・B2B は数えない）
+// ====================================================================
+#pragma once
+
+#include "ai_search.hpp"
+#include "ai_common.hpp"
+#include "ai_thread_pool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace ai {
+
+struct GameConf {
+    int    maxPieces   = 500;  // これだけ置けたら生存として打ち切る
+    int    preview     = 5;    // 探索に見せる next の数
+    double timeLimitMs = 0;    // 1 手の探索時間（0 以下なら depthMax まで）
+};
+
+struct GameResult {
+    int  pieces    = 0;
+    int  lines     = 0;
+    int  attack    = 0;
+    bool toppedOut = false;
+};
+
+// 見える盤面の高さ。これより上にブロックが残ったら負け
+static constexpr int VISIBLE_ROWS = 20;
+
+// 消去数ごとの火力（1:0 2:1 3:2 4:4）
+constexpr int line_attack(int cleared){
+    constexpr int table[5] = {0, 0, 1, 2, 4};
+    return table[std::clamp(cleared, 0, 4)];
+}
+
+inline GameResult play_game(SearchSession& session, std::uint32_t seed, const GameConf& gc)
+{
+    // ホールドの初回だけ 2 個進むので、1 手 1 個 + 窓 + 余裕 で足りる
+    const auto bag = common::generate_queue(std::size_t(gc.maxPieces + gc.preview + 2), seed);
+    std::size_t head = 0;
+    char  hold = 0;
+    Board board;
+    auto window = [&]{
+        const std::size_t end = std::min(bag.size(), head + 1 + std::size_t(gc.preview));
+        return std::span<const char>(bag.data() + head, end - head);
+    };
+
+    GameResult res;
+    session.set_time_limit(gc.timeLimitMs);
+    Node node = session.reset(board, window(), hold);
+    while (res.pieces < gc.maxPieces) {
+        if (node.path.empty()) { res.toppedOut = true; break; }   // 置ける場所がない
+        const Step s = node.path.front();
+
+        board = board | make_piece_board_runtime(s.rot, s.piece, s.x, s.y);
+        const int cleared = board.clear_full_lines();
+        if (s.usedHold) { const char cur = bag[head]; head += (hold == 0) ? 2 : 1; hold = cur; }
+        else            { head += 1; }
+
+        ++res.pieces;
+        res.lines  += cleared;
+        res.attack += line_attack(cleared);
+
+        const auto heights = board.column_heights();
+        if (*std::max_element(heights.begin(), heights.end()) > VISIBLE_ROWS) { res.toppedOut = true; break; }
+
+        node = session.advance(s, board, window(), hold);
+    }
+    return res;
+}
+
+// 生存率と 1 手あたり火力を足したもの（大きいほど良い）
+inline double fitness(std::span<const GameResult> results, const GameConf& gc, double attackWeight = 1.0)
+{
+    if (results.empty()) return 0;
+    double survived = 0, app = 0;
+    for (const auto& r : results) {
+        survived += double(r.pieces) / gc.maxPieces;
+        if (r.pieces > 0) app += double(r.attack) / r.pieces;
+    }
+    return (survived + attackWeight * app) / double(results.size());
+}
+
+// ゲームごとの結果を results に書く（seeds と同じ並び）
+class SelfPlay {
+public:
+    explicit SelfPlay(ThreadPool& workers)
+        : workers_(workers), sessions_(workers.size()) {}
+
+    void run(const Weights& w, std::span<const std::uint32_t> seeds, const GameConf& gc,
+             std::vector<GameResult>& results)
+    {
+        results.assign(seeds.size(), GameResult{});
+        for (auto& s : sessions_) s.set_weights(w);
+        workers_.parallel_for(static_cast<int>(seeds.size()), [&](int g, unsigned wk){
+            results[g] = play_game(sessions_[wk], seeds[g], gc);
+        });
+    }
+
+    double evaluate_weights(const Weights& w, std::span<const std::uint32_t> seeds,
+                            const GameConf& gc, double attackWeight = 1.0)
+    {
+        run(w, seeds, gc, results_);
+        return fitness(results_, gc, attackWeight);
+    }
+
+    const std::vector<GameResult>& last_results() const { return results_; }
+
+private:
+    ThreadPool&                 workers_;
+    std::vector<SearchSession>  sessions_;   // ワーカーごと（容量を使い回す）
+    std::vector<GameResult>     results_;
+};
+
+} // namespace ai
@@ -0,0 +1,124 @@
+// ai_thread_pool.hpp — 探索用の常駐スレッドプール
+// ====================================================================
+// * ai::search の並列展開で使う。スレッドは生成時に立ち上げて使い回す
+// * parallel_for(n, f) は呼び出しスレッドも worker 0 として参加し、
+//   全タスク完了まで戻らない（= 深さループの 1 ステップごとに同期）
+// * タスク割り当ては atomic カウンタで取り合うので、結果の並びを
+//   決定的にしたい場合はタスク index ごとにバッファを分けること
+// ====================================================================
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ai {
+
+class ThreadPool {
+public:
+    // threads: 呼び出しスレッドを含めた総数（0 なら hardware_concurrency）
+    explicit ThreadPool(unsigned threads = 0)
+    {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        workers_.reserve(threads - 1);
+        for (unsigned w = 1; w < threads; ++w)
+            workers_.emplace_back([this, w]{ worker_loop(w); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lk(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 呼び出しスレッドを含めたワーカー数
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // f(taskIndex, workerIndex) を taskIndex = 0..n-1 について実行する
+    // workerIndex は 0..size()-1（スレッドごとのスクラッチ領域の選択用）
+    template<class F>
+    void parallel_for(int n, F&& f)
+    {
+        if (n <= 0) return;
+        if (workers_.empty() || n == 1) {
+            for (int i = 0; i < n; ++i) f(i, 0);
+            return;
+        }
+
+        // 型消去は関数ポインタ + void* で行い、ジョブ毎のヒープ確保を避ける
+        using Fn = std::remove_reference_t<F>;
+        {
+            std::lock_guard lk(mtx_);
+            job_     = [](void* ctx, int i, unsigned w){ (*static_cast<Fn*>(ctx))(i, w); };
+            ctx_     = static_cast<void*>(&f);
+            total_   = n;
+            next_.store(0, std::memory_order_relaxed);
+            pending_ = static_cast<unsigned>(workers_.size());
+            ++generation_;
+        }
+        cv_.notify_all();
+
+        run_tasks(0);
+
+        // 他ワーカーが自分の取り分を終えるまで待つ
+        std::unique_lock lk(mtx_);
+        done_cv_.wait(lk, [&]{ return pending_ == 0; });
+    }
+
+private:
+    using JobFn = void(*)(void*, int, unsigned);
+
+    void run_tasks(unsigned w)
+    {
+        for (;;) {
+            const int i = next_.fetch_add(1, std::memory_order_relaxed);
+            if (i >= total_) break;
+            job_(ctx_, i, w);
+        }
+    }
+
+    void worker_loop(unsigned w)
+    {
+        std::uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock lk(mtx_);
+                cv_.wait(lk, [&]{ return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+            }
+            run_tasks(w);
+            {
+                std::lock_guard lk(mtx_);
+                if (--pending_ == 0) done_cv_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex               mtx_;
+    std::condition_variable  cv_;
+    std::condition_variable  done_cv_;
+    bool                     stop_       = false;
+    std::uint64_t            generation_ = 0;
+    unsigned                 pending_    = 0;
+
+    JobFn            job_   = nullptr;
+    void*            ctx_   = nullptr;
+    int              total_ = 0;
+    std::atomic<int> next_{0};
+};
+
+} // namespace ai
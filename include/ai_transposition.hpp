@@ -0,0 +1,194 @@
+// ai_transposition.hpp — 探索 dedup 用のフラットなトランスポジションテーブル
+// ====================================================================
+// * open addressing + 線形探索。エントリは {key, tag} の 16byte 固定
+// * tag = (generation << ORDER_BITS) | order
+//     generation が現在値と違うスロットは「空」扱い → reset() は世代を
+//     進めるだけでメモリは解放・ゼロクリアしない
+//     order は「逐次展開で何番目に生成された子か」。並列展開では
+//     claim() で order の最小値を atomic に取り合い、最小 order の子だけ
+//     を残すことで逐次版と同じ dedup 結果を得る
+// * insert()  : 単一スレッド用。満杯に近づいたら倍に拡張する
+// * claim()   : ロックフリー版（std::atomic_ref）。拡張はしないので
+//               並列フェーズの前に reserve() しておくこと
+// * Verify    : 空でない型を渡すと key と並べて保存し、key 一致時に
+//               operator== で照合する（ハッシュ衝突による誤 dedup を防ぐ厳密モード）
+// ====================================================================
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace ai {
+
+// 照合なし（key だけで同一視する）
+struct NoVerify {
+    constexpr bool operator==(const NoVerify&) const = default;
+};
+
+template<class Verify = NoVerify>
+class BasicTranspositionTable {
+    static constexpr bool VERIFY = !std::is_empty_v<Verify>;
+public:
+    static constexpr int           ORDER_BITS = 40;
+    static constexpr std::uint64_t ORDER_MASK = (std::uint64_t(1) << ORDER_BITS) - 1;
+    static constexpr std::uint64_t NO_ORDER   = ORDER_MASK;      // 未登録
+    static constexpr std::uint64_t BUSY       = ORDER_MASK - 1;  // claim() で key 書き込み中
+
+    struct Entry {
+        std::uint64_t key = 0;
+        std::uint64_t tag = 0;
+    };
+
+    BasicTranspositionTable() = default;
+    BasicTranspositionTable(BasicTranspositionTable&&) noexcept            = default;
+    BasicTranspositionTable& operator=(BasicTranspositionTable&&) noexcept = default;
+
+    // 全エントリを無効化し、少なくとも minEntries を load factor 1/2 で収められる容量にする
+    void reset(std::size_t minEntries)
+    {
+        count_ = 0;
+        const std::size_t want = std::bit_ceil(std::max<std::size_t>(minEntries * 2, 1024));
+        if (want > capacity_) {
+            allocate(want);
+            return;
+        }
+        // 世代は 24bit。一周したら古い tag と衝突するのでそこだけゼロクリア
+        if (++generation_ >= (std::uint64_t(1) << (64 - ORDER_BITS))) {
+            std::fill_n(entries_.get(), capacity_, Entry{});
+            generation_ = 1;
+        }
+    }
+
+    // 並列フェーズ前に、あと extra 個入っても 3/4 を超えないよう拡張しておく
+    void reserve(std::size_t extra)
+    {
+        while ((count_ + extra) * 4 > capacity_ * 3) grow();
+    }
+
+    std::size_t size()     const { return count_; }
+    std::size_t capacity() const { return capacity_; }
+
+    // 単一スレッド用: 新規なら true
+    bool insert(std::uint64_t key, std::uint64_t order = 0, const Verify& v = {})
+    {
+        if ((count_ + 1) * 4 > capacity_ * 3) grow();
+        const std::uint64_t live = generation_ << ORDER_BITS;
+        for (std::size_t i = index_of(key);; i = (i + 1) & (capacity_ - 1)) {
+            Entry& e = entries_[i];
+            if ((e.tag & ~ORDER_MASK) != live) {
+                e.key = key;
+                e.tag = live | (order & ORDER_MASK);
+                if constexpr (VERIFY) verify_[i] = v;
+                ++count_;
+                return true;
+            }
+            if (same(i, key, v)) return false;
+        }
+    }
+
+    // ロックフリー版: key の所有 order を min(既存, order) に更新する
+    // 戻り値は「呼び出し時点で order が最小（= 自分が残る候補）か」
+    // false なら自分より前に生成された同一状態が既にあるので破棄してよい
+    bool claim(std::uint64_t key, std::uint64_t order, const Verify& v = {})
+    {
+        const std::uint64_t live = generation_ << ORDER_BITS;
+        for (std::size_t n = 0, i = index_of(key); n < capacity_; ++n, i = (i + 1) & (capacity_ - 1)) {
+            std::atomic_ref<std::uint64_t> tag(entries_[i].tag);
+            std::uint64_t t = tag.load(std::memory_order_acquire);
+
+            if ((t & ~ORDER_MASK) != live) {
+                // 空きスロットを BUSY で確保してから key を公開
+                if (tag.compare_exchange_strong(t, live | BUSY, std::memory_order_acq_rel)) {
+                    std::atomic_ref<std::uint64_t>(entries_[i].key).store(key, std::memory_order_relaxed);
+                    if constexpr (VERIFY) verify_[i] = v;   // tag の release 公開より前に書く
+                    tag.store(live | order, std::memory_order_release);
+                    std::atomic_ref<std::size_t>(count_).fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                // strong CAS の失敗 = 他スレッドが現世代で確保済み（t は最新値）
+            }
+            while ((t & ORDER_MASK) == BUSY) t = tag.load(std::memory_order_acquire);
+            if (std::atomic_ref<std::uint64_t>(entries_[i].key).load(std::memory_order_relaxed) != key)
+                continue;
+            if constexpr (VERIFY) { if (!(verify_[i] == v)) continue; }
+
+            while ((t & ORDER_MASK) > order) {
+                if (tag.compare_exchange_weak(t, live | order, std::memory_order_acq_rel))
+                    return true;
+            }
+            return (t & ORDER_MASK) == order;
+        }
+        return true; // 満杯（reserve 不足）。残す側に倒す
+    }
+
+    // key を所有している order（未登録なら NO_ORDER）
+    std::uint64_t owner(std::uint64_t key, const Verify& v = {}) const
+    {
+        const std::uint64_t live = generation_ << ORDER_BITS;
+        for (std::size_t n = 0, i = index_of(key); n < capacity_; ++n, i = (i + 1) & (capacity_ - 1)) {
+            const Entry& e = entries_[i];
+            if ((e.tag & ~ORDER_MASK) != live) return NO_ORDER;
+            if (same(i, key, v)) return e.tag & ORDER_MASK;
+        }
+        return NO_ORDER;
+    }
+
+private:
+    bool same(std::size_t i, std::uint64_t key, const Verify& v) const
+    {
+        if (entries_[i].key != key) return false;
+        if constexpr (VERIFY) return verify_[i] == v;
+        else                  return true;
+    }
+
+    std::size_t index_of(std::uint64_t key) const
+    {
+        // 上位ビットを混ぜてから下位を使う（key の下位が偏っていても散らす）
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity_ - 1);
+    }
+
+    void allocate(std::size_t cap)
+    {
+        entries_    = std::make_unique<Entry[]>(cap);   // 値初期化 = tag 0 = 空
+        if constexpr (VERIFY) verify_ = std::make_unique<Verify[]>(cap);
+        capacity_   = cap;
+        generation_ = 1;
+        count_      = 0;
+    }
+
+    void grow()
+    {
+        auto              old    = std::move(entries_);
+        [[maybe_unused]] auto oldV = std::move(verify_);
+        const std::size_t oldCap = capacity_;
+        const std::uint64_t live = generation_ << ORDER_BITS;
+        allocate(oldCap ? oldCap * 2 : 1024);
+        const std::uint64_t nlive = generation_ << ORDER_BITS;
+        for (std::size_t j = 0; j < oldCap; ++j) {
+            if ((old[j].tag & ~ORDER_MASK) != live) continue;
+            for (std::size_t i = index_of(old[j].key);; i = (i + 1) & (capacity_ - 1)) {
+                if ((entries_[i].tag & ~ORDER_MASK) != nlive) {
+                    entries_[i] = {old[j].key, nlive | (old[j].tag & ORDER_MASK)};
+                    if constexpr (VERIFY) verify_[i] = oldV[j];
+                    ++count_;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::unique_ptr<Entry[]> entries_;
+    std::unique_ptr<std::conditional_t<VERIFY, Verify, char>[]> verify_;
+    std::size_t              capacity_   = 0;
+    std::size_t              count_      = 0;
+    std::uint64_t            generation_ = 1;
+};
+
+using TranspositionTable = BasicTranspositionTable<>;
+
+} // namespace ai
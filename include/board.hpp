@@ -7,11 +7,49 @@
   #include <type_traits>
   #include <cstdint>
   #include <bit>
+  #include <span>
+  #include <algorithm>
   #include <experimental/simd>//問題ないからエラーを無効にしてる。無視してる。
   #include <iostream>
   #include <immintrin.h>
+  #if defined(_MSC_VER)
+  #include <intrin.h>
+  #else
+  #include <cpuid.h>
+  #endif
 
   namespace reachability {
+    // 行消去で _pext_u64 を使うか（起動時に 1 回だけ判定）
+    // BMI2 があっても AMD family 0x17 以前（Zen1/Zen2）の pext はマイクロコード実装で
+    // 数十〜数百サイクルかかるので、その場合は行単位のシフトで詰める
+    inline bool detect_fast_pext() {
+    #if defined(__BMI2__)
+      unsigned r[4] = {};
+      auto cpuid = [&](unsigned leaf, unsigned sub) {
+      #if defined(_MSC_VER)
+        int t[4];
+        __cpuidex(t, static_cast<int>(leaf), static_cast<int>(sub));
+        for (int i = 0; i < 4; ++i) r[i] = static_cast<unsigned>(t[i]);
+      #else
+        __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+      #endif
+      };
+      cpuid(0, 0);
+      const unsigned max_leaf = r[0];
+      const bool amd = r[1] == 0x68747541u && r[3] == 0x69746e65u && r[2] == 0x444d4163u;// "AuthenticAMD"
+      if (max_leaf < 7) return false;
+      cpuid(7, 0);
+      if (!(r[1] >> 8 & 1)) return false;// BMI2 なし
+      cpuid(1, 0);
+      unsigned family = r[0] >> 8 & 0xF;
+      if (family == 0xF) family += r[0] >> 20 & 0xFF;
+      return !(amd && family < 0x19);
+    #else
+      return false;
+    #endif
+    }
+    inline const bool has_fast_pext = detect_fast_pext();
+
     template <unsigned W, unsigned H, typename under_t=std::uint64_t>
       requires
         std::numeric_limits<under_t>::is_integer
@@ -21,6 +59,7 @@
     //盤面の幅, 高さ, およびunder_t型のビット幅を指定
     struct board_t {
       //盤面のビット演算に関する静的定数
+      using under_type = under_t;// 1 レーンの整数型
       static constexpr int under_bits = std::numeric_limits<under_t>::digits;// `under_t` のビット数
       static constexpr int width = W; // 盤面の幅
       static constexpr int height = H; // 盤面の高さ
@@ -315,9 +354,22 @@
         return ret;
       }
 
+      // 揃った行を消して上の行を詰め、消した行数を返す
+      // * 揃った行が無ければ（大半の手）行判定だけで戻る
+      // * レーン内の詰め方は起動時に選ぶ: pext が速い CPU は _pext_u64、
+      //   それ以外（pext がマイクロコードの Zen1/Zen2、BMI2 なし）は行単位のシフト
       constexpr int clear_full_lines() {
+      #if defined(__BMI2__)
+          if constexpr (sizeof(under_t) == sizeof(std::uint64_t)) {
+            if (has_fast_pext) return clear_full_lines_impl<true>();
+          }
+      #endif
+          return clear_full_lines_impl<false>();
+      }
+
+      template <bool USE_PEXT>
+      constexpr int clear_full_lines_impl() {
           data_t v = data;
-          constexpr unsigned rows_per_lane = lines_per_under;
           data_t filled = v;
           constexpr int needed = std::numeric_limits<decltype(W)>::digits - std::countl_zero(W) - 1;
           static_for<needed>([&](auto i){
@@ -330,78 +382,64 @@
             data_t mask = row_rshift<rem>(filled);
             filled &= mask;
           }
+          // filled: 揃った行の右端（x=0）だけが立つ
+          if (!any_of(filled != data_t(0))) return 0;
+
           data_t allfilled = filled;
           static_for<W>([&](auto i){
             constexpr int S = static_cast<int>(i);
             allfilled |= row_lshift<S>(filled);
           });
-          //debug　ここは問題なさそう
-          // board_t lane_board;
-          // lane_board.data = filled;
-          // std::cout << "filled: " << "\n" << to_string(lane_board) << "\n";
-          // board_t lane_board2;
-          // lane_board2.data = allfilled;
-          // std::cout << "allfilled: " << "\n" << to_string(lane_board2) << "\n";
-
-
 
+          // レーンごとに揃った行を抜いて下へ詰める
           int lanepopcnts[num_of_under] = {0};
-          under_t lane_filled;
-          under_t lane_allfilled;
-          under_t lane_v;
           static_for<num_of_under>([&](auto i){
-
-            constexpr std::size_t L = num_of_under  - 1 - static_cast<int>(i);
-            lane_filled = static_cast<under_t>(filled[L]);
-            lane_allfilled = static_cast<under_t>(allfilled[L]);
-            lane_v = static_cast<under_t>(v[L]);
-            // debug
-            //std::cout << "lane_v:before: " << "\n" <<  to_string_data_t_64(lane_v) << "\n";
-            lane_v  = _pext_u64(lane_v, ~lane_allfilled);
-            v[L] = lane_v;
-            lanepopcnts[L] = std::popcount(static_cast<under_t>(filled[L]));
-
-            // debug
-            // std::cout << "lanepopcnts: " << i << "\n" << lanepopcnts[L] << "\n";
-            // std::cout << "lane_filled: " << "\n" << to_string_data_t_64(lane_filled) << "\n";
-            // std::cout << "lane_v:after: " << "\n" <<  to_string_data_t_64(lane_v) << "\n";
-            //std::cout << "lane_allfilled: " << "\n" << to_string_data_t_64(lane_allfilled) << "\n";
-
-           
+            constexpr std::size_t L = static_cast<std::size_t>(i);
+            const under_t lane_filled = static_cast<under_t>(filled[L]);
+            if (lane_filled == 0) return;
+            const under_t lane_v = static_cast<under_t>(v[L]);
+          #if defined(__BMI2__)
+            if constexpr (USE_PEXT) {
+              v[L] = _pext_u64(lane_v, ~static_cast<under_t>(allfilled[L]));
+            } else
+          #endif
+            {
+              v[L] = compact_rows(lane_v, lane_filled);
+            }
+            lanepopcnts[L] = std::popcount(lane_filled);
           });
 
-          //debug
-          // board_t lane_board;
-          // lane_board.data = v;
-          // std::cout << "pext後" << "\n" << to_string(lane_board) << "\n";
-
+          // 詰めた各レーンの残り行を下から順に並べ直す
+          // （消えた行が 1 レーン分を超えても、2 つ以上上のレーンから正しく引き下ろせる）
+          under_t out[num_of_under] = {};
+          int dst = 0;// 書き込み済みの行数
           int countpopcnts = 0;
-          under_t lane_L0;
-          under_t lane_L1;
           static_for<num_of_under>([&](auto i){
-            constexpr std::size_t L = static_cast<int>(i);//下から
-            if constexpr (L != 0) {
-              lane_L0 = static_cast<under_t>(v[L]);
-              lane_L0 >>= (countpopcnts * W);
-              //debug
-              //std::cout << "lane_L0: " << L << "\n" << to_string_data_t_64(lane_L0) << "\n";
-              v[L] = lane_L0;
-            }
-            countpopcnts += lanepopcnts[L]; 
-            if constexpr (!(L == num_of_under - 1)) {
-              lane_L0 = static_cast<under_t>(v[L]);
-              lane_L1 = static_cast<under_t>(v[L+1]);
-              lane_L0 |= (lane_L1 << (used_bits_per_under - countpopcnts * W));
-              v[L] = lane_L0;
-            }
-            
-            // debug
-            // board_t lane_board;
-            // lane_board.data = v;
-            // std::cout << "lane_board: "<< L << "\n" << to_string(lane_board) << "\n";
+            constexpr std::size_t L = static_cast<std::size_t>(i);//下から
+            constexpr int lane_rows = (L == last) ? static_cast<int>(H) - last * lines_per_under : lines_per_under;
+            const int rows = lane_rows - lanepopcnts[L];
+            const under_t bits = static_cast<under_t>(v[L]);
+            const int lane = dst / lines_per_under;
+            const int off = dst % lines_per_under;
+            out[lane] |= bits << (off * W);
+            if (off + rows > lines_per_under) out[lane + 1] |= bits >> ((lines_per_under - off) * W);
+            dst += rows;
+            countpopcnts += lanepopcnts[L];
           });
-          data = v; 
-          return lanepopcnts[0]+lanepopcnts[1]+lanepopcnts[2]+lanepopcnts[3];
+          data = data_t([&](auto i){ return out[i]; }) & mask_board();// はみ出した盤面外ビットは落とす
+          return countpopcnts;
+      }
+
+      // レーン内の揃った行（rows_filled = 各行の右端ビット）を抜いて上の行を下げる（pext なし）
+      // 上の行から抜くので、まだ抜いていない行の位置はずれない
+      static constexpr under_t compact_rows(under_t v, under_t rows_filled) {
+        while (rows_filled) {
+          const int bit = std::bit_width(rows_filled) - 1;
+          const under_t below = (under_t(1) << (bit / W * W)) - 1;
+          v = (v & below) | ((v >> W) & ~below);
+          rows_filled &= ~(under_t(1) << bit);
+        }
+        return v;
       }
 
       // 盤面に唯一のビットが存在するかを確認する関数
@@ -479,6 +517,148 @@
         });
         return total;
       }
+
+      // 各 `under_t` をそのまま配列で取り出す関数（盤面の完全な比較・保存用）
+      constexpr std::array<under_t, num_of_under> lanes() const {
+        std::array<under_t, num_of_under> ret{};
+        static_for<num_of_under>([&](auto I){
+          ret[I] = static_cast<under_t>(data[I]);
+        });
+        return ret;
+      }
+
+      // 盤面全体の 64bit ハッシュ（lane ごとに乗算・xorshift で混ぜる）
+      // セル 1 つの違いでも全ビットに波及するので、高さだけのシグネチャと違い穴の有無も区別できる
+      constexpr std::uint64_t hash(std::uint64_t seed = 0) const noexcept {
+        // seed は先に攪拌しておく（生のまま lane と xor すると下位ビットで打ち消し合う）
+        std::uint64_t h = (seed + 0x243F6A8885A308D3ULL) * 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 32;
+        static_for<num_of_under>([&](auto I){
+          h ^= static_cast<std::uint64_t>(data[I]) + 0x9E3779B97F4A7C15ULL * (I + 1);
+          h *= 0xBF58476D1CE4E5B9ULL;
+          h ^= h >> 31;
+        });
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 29;
+        return h;
+      }
+
+      // 下方向に塗りつぶした盤面: (x, y) 以上（自分を含む）に同じ列のブロックがあれば 1
+      // 1, 2, 4, ... 段ずつ下に重ねるので log2(H) 回の SIMD シフトで済む
+      constexpr board_t fill_down() const {
+        board_t s = *this;
+        constexpr int steps = std::bit_width(H - 1);
+        static_for<steps>([&](auto I){
+          s |= s.template move<coord{0, -(1 << I)}, false>();
+        });
+        return s;
+      }
+
+      // 1 つの `under_t` 内で x 列にあたるビット
+      static constexpr under_t column_mask(int x) {
+        under_t m = 0;
+        for (int r = 0; r < lines_per_under; ++r) m |= under_t(1) << (r * W + x);
+        return m;
+      }
+
+      // 各列の高さ（最上段の y+1、空なら 0）と穴（最上段より下の空白）の数
+      struct column_profile {
+        std::array<int, W> height{};
+        std::array<int, W> holes{};
+        int total_holes = 0;
+      };
+
+      // fill_down した列は下から連続で埋まるので、高さ = 列の popcount、
+      // 穴 = (fill_down & ~盤面) の popcount になる
+      constexpr column_profile columns() const {
+        column_profile ret;
+        const board_t filled = fill_down();
+        const board_t holes  = filled & ~*this;
+        static_for<num_of_under>([&](auto I){
+          const under_t f = static_cast<under_t>(filled.data[I]);
+          const under_t e = static_cast<under_t>(holes.data[I]);
+          static_for<W>([&](auto x){
+            constexpr under_t cm = column_mask(x);
+            ret.height[x] += std::popcount(f & cm);
+            ret.holes[x]  += std::popcount(e & cm);
+          });
+        });
+        ret.total_holes = holes.bitcount();
+        return ret;
+      }
+
+      // 各列の高さだけ（穴の数え上げを省く）
+      constexpr std::array<int, W> column_heights() const {
+        std::array<int, W> ret{};
+        const board_t filled = fill_down();
+        static_for<num_of_under>([&](auto I){
+          const under_t f = static_cast<under_t>(filled.data[I]);
+          static_for<W>([&](auto x){
+            ret[x] += std::popcount(f & column_mask(x));
+          });
+        });
+        return ret;
+      }
+
+      // y 段目から上の全行（y は [0, H] に丸める）
+      static constexpr board_t rows_from(int y) {
+        return board_t(rows_from_table[std::clamp(y, 0, static_cast<int>(H))]);
+      }
+
+      // 下 n 段のゴミ行（hole_columns のビット x が立つ列を穴にする）
+      static constexpr board_t garbage_rows(int n, under_t hole_columns) {
+        constexpr under_t full_row = under_t(-1) >> (under_bits - W);
+        board_t g;
+        g.data = data_t(static_cast<under_t>((full_row & ~hole_columns) * column_mask(0)));
+        return g & ~rows_from(n);
+      }
+
+      // せり上がり: 盤面全体を n 段上げる（下 n 段は空く）
+      // 戻り値はトップアウトしたか = 上げた後に top 段目以上へ来るブロック（盤面外へ押し出されるものを含む）があるか
+      template <int N>
+      constexpr bool rise_(int top = H) {
+        static_assert(0 <= N && N <= static_cast<int>(H));
+        const bool out = (*this & rows_from(top - N)).any();
+        if constexpr (N != 0) move_<coord{0, N}, false>();
+        return out;
+      }
+      constexpr bool rise(int n, int top = H) {
+        const bool out = (*this & rows_from(top - n)).any();
+        data = rise_rows(data, n);
+        return out;
+      }
+
+      // ゴミ行を n 段下から差し込む（対戦のせり上がり）。戻り値はトップアウトしたか
+      //   b.add_garbage(2, 1 << 3);            // 3 列目が穴の 2 段
+      //   b.add_garbage(1, (1 << 0) | (1 << 9)); // 穴が 2 つの 1 段
+      constexpr bool add_garbage(int n, under_t hole_columns, int top = H) {
+        const bool out = rise(n, top);
+        *this |= garbage_rows(n, hole_columns);
+        return out;
+      }
+      template <int N>
+      constexpr bool add_garbage_(under_t hole_columns, int top = H) {
+        const bool out = rise_<N>(top);
+        *this |= garbage_rows(N, hole_columns);
+        return out;
+      }
+
+      // 同じゴミを多数の盤面にまとめて差し込む（ゴミ行と判定マスクは 1 回だけ作る）
+      // topped_out が空でなければ盤面ごとの結果（0/1）を書く。トップアウトした盤面の数を返す
+      static int add_garbage_batch(std::span<board_t> boards, int n, under_t hole_columns,
+                                   std::span<std::uint8_t> topped_out = {}, int top = H) {
+        const board_t garbage = garbage_rows(n, hole_columns);
+        const board_t danger = rows_from(top - n);
+        int count = 0;
+        for (std::size_t i = 0; i < boards.size(); ++i) {
+          board_t& b = boards[i];
+          const bool out = (b & danger).any();
+          b.data = rise_rows(b.data, n) | garbage.data;
+          count += out;
+          if (i < topped_out.size()) topped_out[i] = out;
+        }
+        return count;
+      }
     private:
     // SIMD 型の定義
       template <std::size_t N>
@@ -492,6 +672,28 @@
         ret.data = data;
         return ret;
       }
+      // rows_from の表（y = 0..H）
+      static constexpr auto rows_from_table = [] {
+        std::array<std::array<under_t, num_of_under>, H + 1> t{};
+        for (int y = 0; y <= static_cast<int>(H); ++y)
+          for (int r = y; r < static_cast<int>(H); ++r)
+            t[y][r / lines_per_under] |= (under_t(-1) >> (under_bits - W)) << (r % lines_per_under * W);
+        return t;
+      }();
+      // 実行時の段数 n（[0, H] に丸める）で盤面を上げる
+      // レーン単位のずらし（n/lines_per_under）は各ビットごとに my_split を選び、
+      // レーン内の (n%lines_per_under) 行はシフト量を実行時に渡す。分岐もメモリ経由もなし
+      [[gnu::always_inline]] static constexpr data_t rise_rows(data_t v, int n) {
+        n = std::clamp(n, 0, static_cast<int>(H));
+        const int pad = n / lines_per_under;
+        static_for<std::bit_width(unsigned(num_of_under))>([&](auto k){
+          const data_t take = data_t(under_t(0) - under_t(pad >> k & 1));
+          v = (my_split<(1 << k), true>(v) & take) | (v & ~take);
+        });
+        const int lo_shift = n % lines_per_under * W;
+        const int hi_shift = used_bits_per_under - lo_shift - 1;// lo_shift == 0 でも under_bits 未満に収める
+        return ((v << lo_shift) | ((my_split<1, true>(v) >> 1) >> hi_shift)) & mask_board();
+      }
       // 指定方向の移動制限マスクを生成する関数
       template <int dx>
       static constexpr data_t mask_move() {
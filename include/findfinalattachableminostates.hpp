@@ -6,6 +6,8 @@
 #include <array>
 #include <type_traits>
 #include <span> 
+#include <string_view>
+#include <algorithm>
 
 namespace reachability::search {
   using namespace blocks;
@@ -20,6 +22,61 @@ namespace reachability::search {
     });
     return positions;// 使用可能な場所を返す
   }
+  //複数のミノで共有する空きマスのシフト盤面
+  //usable_positions の (~data).move<-c>() に出てくる c は、回転系の全ミノ・全形状を合わせても
+  //十数通りしかない。盤面 1 つに対してそれを 1 回ずつだけ作り、各ミノで使い回す
+  template <typename RS>
+  struct free_shift_table {
+    static constexpr auto build() {
+      std::array<coord, 7 * 4 * 4> offs{};
+      std::size_t n = 0;
+      auto add = [&](const auto &b) {
+        for (const auto &mino : b.minos)
+          for (const auto &c : mino)
+            if (std::find(offs.begin(), offs.begin() + n, -c) == offs.begin() + n) offs[n++] = -c;
+      };
+      add(RS::T); add(RS::Z); add(RS::S); add(RS::J); add(RS::L); add(RS::O); add(RS::I);
+      return std::pair{offs, n};
+    }
+    static constexpr std::size_t size = build().second;
+    static constexpr auto offsets = [] {
+      std::array<coord, size> ret{};
+      std::copy_n(build().first.begin(), size, ret.begin());
+      return ret;
+    }();
+    static constexpr std::size_t index_of(coord c) {
+      return static_cast<std::size_t>(std::find(offsets.begin(), offsets.end(), c) - offsets.begin());
+    }
+  };
+
+  template <typename RS, typename board_t>
+  struct free_shifts {
+    using table = free_shift_table<RS>;
+    std::array<board_t, table::size> shifted;// shifted[k] = (~data).move<table::offsets[k]>()
+
+    constexpr explicit free_shifts(board_t data) {
+      const board_t free = ~data;
+      static_for<table::size>([&][[gnu::always_inline]](auto k) {
+        shifted[k] = free.template move<table::offsets[k]>();
+      });
+    }
+    template <coord c>
+    constexpr const board_t &get() const {
+      constexpr std::size_t k = table::index_of(c);
+      static_assert(k < table::size, "offset is not in the table of this rotation system");
+      return shifted[k];
+    }
+  };
+
+  //usable_positions の共有シフト版（結果は盤面から直接計算したものと同じ）
+  template <std::array mino, typename RS, typename board_t>
+  constexpr board_t usable_positions(const free_shifts<RS, board_t> &shifts) {
+    board_t positions = ~board_t();
+    static_for<mino.size()>([&][[gnu::always_inline]](auto i) {
+      positions &= shifts.template get<-mino[i]>();
+    });
+    return positions;
+  }
   //ブロックを落とした際の着地可能位置を計算する関数
   //usable:使用可能な位置
   //usable:のうち、下に移動できない (固定される) 位置を計算
@@ -40,31 +97,26 @@ namespace reachability::search {
   // - `block`: 探索対象のブロック
   // - `start`: ブロックの初期位置
   // - `init_rot`: 初期の回転状態
-  // - `data`: 盤面の状態
+  // - `usable`: 各形状の使用可能位置
+  // - `cache`: 各向きの到達可能位置（出力）。初期位置が無効なら false
   template <block block, coord start, unsigned init_rot, typename board_t>
-  constexpr std::array<board_t, block.SHAPES> binary_bfs(board_t data) {
+  [[gnu::always_inline]]
+  constexpr bool reach_positions(const board_t (&usable)[block.SHAPES],
+                                 std::array<board_t, block.ORIENTATIONS> &cache) {
     constexpr int orientations = block.ORIENTATIONS;// ブロックの回転状態の数
     constexpr int rotations = block.ROTATIONS;// 回転操作の数
     constexpr int kicks = block.KICK_PER_ROTATION;// 壁蹴りの数
-    constexpr int shapes = block.SHAPES;// ブロックの形状の数
-    
-    board_t usable[shapes];// 各形状ごとの使用可能位置を計算　newjadeさんの記事の事前計算の部分を全パターンやってる部分
-    static_for<shapes>([&][[gnu::always_inline]](auto i) {
-      usable[i] = usable_positions<block.minos[i]>(data);
-    });
     // 移動可能な方向 (左, 右, 下)
     constexpr std::array<coord, 3> MOVES = {{{-1, 0}, {1, 0}, {0, -1}}};
     // 初期配置位置の計算 (盤面上のスタート位置を調整)
     constexpr coord start2 = start + block.mino_offset[init_rot];
     constexpr auto init_rot2 = block.mino_index[init_rot];
     if (!usable[init_rot2].template get<start2[0], start2[1]>()) [[unlikely]] {
-      return {};// 初期位置が無効なら空の結果を返す
+      return false;// 初期位置が無効
     }
     // 各回転状態ごとの訪問状態を管理 (BFSのための探索キュー的な役割)
     bool need_visit[orientations] = { };
     need_visit[init_rot] = true;
-    // 到達可能な盤面データをキャッシュ
-    std::array<board_t, orientations> cache;
     const auto consecutive = consecutive_lines(usable[init_rot2]);
     // 連続したラインがある場合の処理 (完全なラインを削除しながら探索)
     if (consecutive.template get<start2[1]>()) [[likely]] {
@@ -128,6 +180,25 @@ namespace reachability::search {
         });
       });
     }
+    return true;
+  }
+
+  // binary_bfs 本体: 到達可能位置のうち着地できる位置を形状ごとに返す
+  // - `source`: 盤面の状態（board_t）か、その盤面の free_shifts
+  template <block block, coord start, unsigned init_rot, typename board_t, typename source_t>
+  constexpr std::array<board_t, block.SHAPES> binary_bfs_from(const source_t &source) {
+    constexpr int orientations = block.ORIENTATIONS;// ブロックの回転状態の数
+    constexpr int shapes = block.SHAPES;// ブロックの形状の数
+
+    board_t usable[shapes];// 各形状ごとの使用可能位置を計算　newjadeさんの記事の事前計算の部分を全パターンやってる部分
+    static_for<shapes>([&][[gnu::always_inline]](auto i) {
+      usable[i] = usable_positions<block.minos[i]>(source);
+    });
+    // 到達可能な盤面データをキャッシュ
+    std::array<board_t, orientations> cache;
+    if (!reach_positions<block, start, init_rot>(usable, cache)) [[unlikely]] {
+      return {};// 初期位置が無効なら空の結果を返す
+    }
     // 最終的な到達可能位置を格納する配列を作成
     std::array<board_t, shapes> ret;
     // 各回転状態のキャッシュを `shapes` に格納 (ブロックの形状ごとに統合)
@@ -142,6 +213,92 @@ namespace reachability::search {
     return ret;// 最終的な到達可能な位置を返す
   }
 
+  // - `data`: 盤面の状態
+  template <block block, coord start, unsigned init_rot, typename board_t>
+  constexpr std::array<board_t, block.SHAPES> binary_bfs(board_t data) {
+    return binary_bfs_from<block, start, init_rot, board_t>(data);
+  }
+
+  // 回転で入った着地位置つきの binary_bfs の結果
+  // - `land`: binary_bfs と同じ
+  // - `spin`: land のうち、最後の操作を回転にして入れる位置（着地位置なのでそのまま固定される）
+  // - `kick[s][k]`: spin のうち、キック k（0 = キックなし）で入れる位置。
+  //   別の向き・別のキックからも入れる位置は複数の k に立つ
+  template <typename board_t, int shapes, int kicks>
+  struct spin_landings {
+    std::size_t used = shapes;// 有効な形状の数
+    std::array<board_t, shapes> land{};
+    std::array<board_t, shapes> spin{};
+    std::array<std::array<board_t, kicks>, shapes> kick{};
+  };
+
+  template <block block, coord start, unsigned init_rot, typename board_t>
+  constexpr spin_landings<board_t, block.SHAPES, block.KICK_PER_ROTATION> binary_bfs_spin(board_t data) {
+    constexpr int orientations = block.ORIENTATIONS;
+    constexpr int rotations = block.ROTATIONS;
+    constexpr int kicks = block.KICK_PER_ROTATION;
+    constexpr int shapes = block.SHAPES;
+
+    spin_landings<board_t, shapes, kicks> ret;
+    board_t usable[shapes];
+    static_for<shapes>([&][[gnu::always_inline]](auto i) {
+      usable[i] = usable_positions<block.minos[i]>(data);
+    });
+    std::array<board_t, orientations> cache;
+    if (!reach_positions<block, start, init_rot>(usable, cache)) [[unlikely]] {
+      return ret;
+    }
+    static_for<orientations>([&][[gnu::always_inline]](auto i){
+      ret.land[block.mino_index[i]] |= cache[i];
+    });
+    // 到達済みの全位置から 1 回だけ回転し、キック k で入った位置を集める（BFS の回転と同じ判定）
+    if constexpr (rotations > 0) {
+      static_for<orientations>([&][[gnu::always_inline]](auto i){
+        static_for<rotations>([&][[gnu::always_inline]](auto j){
+          constexpr int target = block.rotation_target(i, j);
+          constexpr auto index2 = block.mino_index[target];
+          board_t temp = cache[i];
+          static_for<kicks>([&][[gnu::always_inline]](auto k){
+            ret.kick[index2][k] |= temp.template move<block.kicks[i][j][k]>() & usable[index2];
+            temp &= ~usable[index2].template move<-block.kicks[i][j][k]>();
+          });
+        });
+      });
+    }
+    static_for<shapes>([&][[gnu::always_inline]](auto i){
+      const board_t landable = landable_positions(usable[i]);
+      ret.land[i] &= landable;
+      static_for<kicks>([&][[gnu::always_inline]](auto k){
+        ret.kick[i][k] &= landable;
+        ret.spin[i] |= ret.kick[i][k];
+      });
+    });
+    return ret;
+  }
+
+  // 真上から落とすだけで全部届く盤面か
+  // 張り出し（上にブロックがある空白）が無ければ、空いている置き場所は真上へ抜けられる。
+  // さらにスタックが出現位置より十分低ければ出現行で全形状・全列へ移動できるので、
+  // 到達可能位置 = 使用可能位置 になり、回転・壁蹴りの探索はいらない
+  template <coord start, typename board_t>
+  constexpr bool straight_drop_only(board_t data) {
+    constexpr int margin = 3;// 出現行の下にミノ 1 つ分（中心から最大 2 マス）の余白
+    constexpr int limit = start[1] - margin;
+    static_assert(limit > 0);
+    const board_t above = data & (~board_t()).template move<coord{0, limit}>();
+    return !above.any() && !(data.fill_down() != data);
+  }
+
+  // straight_drop_only な盤面での binary_bfs（各形状の着地位置をそのまま返す）
+  template <block block, coord start, unsigned init_rot, typename board_t>
+  constexpr std::array<board_t, block.SHAPES> hard_drop_landings(board_t data) {
+    std::array<board_t, block.SHAPES> ret;
+    static_for<block.SHAPES>([&][[gnu::always_inline]](auto i) {
+      ret[i] = landable_positions(usable_positions<block.minos[i]>(data));
+    });
+    return ret;
+  }
+
   // バイナリBFS (binary_bfs) のエントリーポイント関数
   // - `RS`: 回転システム (SRS など)
   // - `start`: 初期座標
@@ -165,4 +322,81 @@ namespace reachability::search {
       return static_vector<board_t, 4>{std::span{ret}};
     });
   }
-}
\ No newline at end of file
+
+  // 真上から落とせる盤面では BFS を省く binary_bfs（結果は binary_bfs と同じ）
+  template <typename RS, coord start, unsigned init_rot=0, typename board_t>
+  [[gnu::noinline]]
+  constexpr static_vector<board_t, 4> binary_bfs_fast(board_t data, char b) {
+    const bool open = straight_drop_only<start>(data);
+    return call_with_block<RS>(b, [=]<block B>() {
+      auto ret = open ? hard_drop_landings<B, start, init_rot>(data)
+                      : binary_bfs_from<B, start, init_rot, board_t>(data);
+      return static_vector<board_t, 4>{std::span{ret}};
+    });
+  }
+
+  // 呼び出し側のバッファに直接書く binary_bfs / binary_bfs_fast（static_vector を経由するコピーなし）
+  // out[0, 戻り値) に形状ごとの着地位置を書き、形状数を返す（out[戻り値, 4) はそのまま）
+  template <typename RS, coord start, unsigned init_rot=0, typename board_t>
+  [[gnu::noinline]]
+  constexpr std::size_t binary_bfs_into(board_t data, char b, std::span<board_t, 4> out) {
+    return call_with_block<RS>(b, [&]<block B>() {
+      const auto ret = binary_bfs<B, start, init_rot>(data);
+      std::copy(ret.begin(), ret.end(), out.begin());
+      return std::size_t(B.SHAPES);
+    });
+  }
+
+  template <typename RS, coord start, unsigned init_rot=0, typename board_t>
+  [[gnu::noinline]]
+  constexpr std::size_t binary_bfs_fast_into(board_t data, char b, std::span<board_t, 4> out) {
+    const bool open = straight_drop_only<start>(data);
+    return call_with_block<RS>(b, [&]<block B>() {
+      const auto ret = open ? hard_drop_landings<B, start, init_rot>(data)
+                            : binary_bfs_from<B, start, init_rot, board_t>(data);
+      std::copy(ret.begin(), ret.end(), out.begin());
+      return std::size_t(B.SHAPES);
+    });
+  }
+
+  // ミノをコンパイル時に解決して f(std::span<const board_t, 形状数>) を呼ぶ（結果は f の中だけ有効）
+  // テンプレートの探索コードから、形状数を定数のまま・コピーなしで使うとき用
+  template <typename RS, coord start, unsigned init_rot=0, typename board_t, typename F>
+  [[gnu::always_inline]] constexpr decltype(auto) visit_binary_bfs(board_t data, char b, F &&f) {
+    return call_with_block<RS>(b, [&]<block B>() -> decltype(auto) {
+      const auto ret = binary_bfs<B, start, init_rot>(data);
+      return f(std::span<const board_t, B.SHAPES>{ret});
+    });
+  }
+
+  // 回転で入った着地位置つきの binary_bfs（形状 4・キック 5 に揃えて返す。used が有効な形状数）
+  template <typename RS, coord start, unsigned init_rot=0, typename board_t>
+  [[gnu::noinline]]
+  constexpr spin_landings<board_t, 4, 5> binary_bfs_spin(board_t data, char b) {
+    return call_with_block<RS>(b, [=]<block B>() {
+      const auto r = binary_bfs_spin<B, start, init_rot>(data);
+      spin_landings<board_t, 4, 5> ret;
+      ret.used = B.SHAPES;
+      for (int i = 0; i < B.SHAPES; ++i) {
+        ret.land[i] = r.land[i];
+        ret.spin[i] = r.spin[i];
+        for (int k = 0; k < B.KICK_PER_ROTATION; ++k) ret.kick[i][k] = r.kick[i][k];
+      }
+      return ret;
+    });
+  }
+
+  // 1 つの盤面で複数のミノの binary_bfs をまとめて行う
+  // 空きマスのシフト盤面を 1 回だけ作り、pieces の各ミノで使い回す
+  // f(piece, static_vector<board_t, 4>) を pieces の順に呼ぶ（結果は binary_bfs と同じ）
+  template <typename RS, coord start, unsigned init_rot=0, typename board_t, typename F>
+  constexpr void binary_bfs_batch(board_t data, std::string_view pieces, F &&f) {
+    const free_shifts<RS, board_t> shifts(data);
+    for (char b : pieces) {
+      f(b, call_with_block<RS>(b, [&]<block B>() {
+        auto ret = binary_bfs_from<B, start, init_rot, board_t>(shifts);
+        return static_vector<board_t, 4>{std::span{ret}};
+      }));
+    }
+  }
+}
@@ -0,0 +1,136 @@
+// game_sim.hpp — 決定的なゲームシミュレータ（GameStateSource の実機なし版）
+// ====================================================================
+// * SevenBag(seed) のミノ列で、(4,20) 向き 0 にスポーンしたミノをキー入力で動かす
+//   （座標・SRS のキックは build_input_path と同じ。soft は 1 段）
+// * 1 回の press / idle で 1 フレーム進む。重力・ロック遅延・せり上がりは無い
+// * hard で固定 → ライン消去 → 次のミノ。hold は 1 ミノ 1 回
+// * スポーン位置が塞がったら / maxPieces 個置いたら finished
+// ====================================================================
+#pragma once
+
+#include "game_source.hpp"
+#include "ai_common.hpp"
+#include "ai_path.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace ai {
+
+class SimSource : public GameStateSource {
+public:
+    static constexpr int SPAWN_X = 4, SPAWN_Y = 20;
+
+    explicit SimSource(std::uint32_t seed, int maxPieces = 500)
+        : maxPieces_(maxPieces),
+          bag_(common::generate_queue(std::size_t(maxPieces) + GameState::NEXT_NUM + 2, seed))
+    {
+        spawn(bag_[head_++]);
+    }
+
+    void read(GameState& out) override
+    {
+        out = GameState{};
+        out.inMatch = !over_;
+        out.frame   = frame_;
+        if (over_) return;
+        for (int y = 0; y < GameState::HEIGHT; ++y)
+            for (int x = 0; x < GameState::WIDTH; ++x)
+                if (board_.get(x, y)) out.rows[y] |= std::uint16_t(1u << x);
+        out.current = piece_;
+        out.pieceId = pieceId_;
+        for (int i = 0; i < GameState::NEXT_NUM && head_ + i < bag_.size(); ++i) out.next[i] = bag_[head_ + i];
+        out.hold = hold_;
+    }
+
+    KeyResult press(std::span<const Key> keys) override
+    {
+        ++frame_;
+        KeyResult r{};
+        if (over_) return r;
+        for (Key k : keys) {
+            const std::uint64_t before = pieceId_;
+            switch (k) {
+            case Key::Left:  r.ok |= shift(-1, 0); break;
+            case Key::Right: r.ok |= shift(+1, 0); break;
+            case Key::Soft:  r.ok |= shift(0, -1); break;
+            case Key::Cw:    r.ok |= rotate(0);    break;
+            case Key::Ccw:   r.ok |= rotate(1);    break;
+            case Key::Hard:  lock();               break;
+            case Key::Hold:  swap_hold();          break;
+            }
+            if (pieceId_ != before) { r.ok = true; r.pieceChanged = true; }
+            if (over_) break;
+        }
+        return r;
+    }
+
+    void idle(int) override { ++frame_; }
+    bool finished() const override { return over_; }
+
+    int  pieces()    const { return pieces_; }
+    int  lines()     const { return lines_; }
+    bool toppedOut() const { return toppedOut_; }
+    char hold()      const { return hold_; }
+    const Board& board() const { return board_; }
+
+private:
+    bool shift(int dx, int dy)
+    {
+        if (!can_place(board_, piece_, x_ + dx, y_ + dy, rot_)) return false;
+        x_ += dx; y_ += dy;
+        return true;
+    }
+
+    bool rotate(int dir)
+    {
+        const auto r = try_rotate(board_, piece_, x_, y_, rot_, dir);
+        if (!r) return false;
+        x_ = r->x; y_ = r->y; rot_ = r->rot;
+        return true;
+    }
+
+    void lock()
+    {
+        while (can_place(board_, piece_, x_, y_ - 1, rot_)) --y_;
+        board_ = board_ | PieceTable::cells(piece_, rot_, x_, y_);
+        lines_ += board_.clear_full_lines();
+        ++pieces_;
+        held_ = false;
+        if (pieces_ >= maxPieces_) { over_ = true; return; }
+        spawn(bag_[head_++]);
+    }
+
+    void swap_hold()
+    {
+        if (held_) return;
+        const char cur = piece_;
+        const char nxt = hold_ ? hold_ : bag_[head_++];
+        hold_ = cur;
+        held_ = true;
+        spawn(nxt);
+    }
+
+    void spawn(char p)
+    {
+        piece_ = p;
+        x_ = SPAWN_X; y_ = SPAWN_Y; rot_ = 0;
+        ++pieceId_;
+        if (!can_place(board_, piece_, x_, y_, rot_)) { over_ = true; toppedOut_ = true; }
+    }
+
+    int               maxPieces_;
+    std::vector<char> bag_;
+    std::size_t       head_ = 0;
+    Board             board_{};
+    char              piece_ = 0, hold_ = 0;
+    bool              held_ = false;
+    int               x_ = 0, y_ = 0, rot_ = 0;
+    std::uint64_t     pieceId_ = 0;
+    std::int32_t      frame_ = 0;
+    int               pieces_ = 0, lines_ = 0;
+    bool              over_ = false, toppedOut_ = false;
+};
+
+} // namespace ai
@@ -0,0 +1,185 @@
+// game_source.hpp — ボットが見るゲーム状態と入力先の抽象化
+// ====================================================================
+// * GameStateSource : 状態を読む（read）/ キーを押して反応を待つ（press）/ 待つ（idle）
+//     - 実機     : platform/win/PPT1MemSource.hpp（ReadProcessMemory + SendInput）
+//     - リプレイ : ReplaySource（記録した状態を 1 read = 1 行で流す。入力は記録するだけ）
+//     - シミュ   : game_sim.hpp の SimSource（7-bag で決定的に進む。入力がそのまま効く）
+//   ai_runner.hpp の run_bot はこの口だけを使うので、実機なしで Linux でも回せる
+// * 盤面は EnginePosition と同じく下から 1 段ずつの行ビット（bit x = x 列目）
+// * テキスト形式（1 行 1 状態。RecordingSource が書き、ReplaySource が読む）:
+//     <frame> <盤面> <現在のミノ> <ネクスト> <ホールド> <id> <locked>
+//     盤面は beatris_cli と同じ（上の段から '/' 区切り、空の盤面は "-"）。
+//     ミノが無い / ネクストが無い / ホールドが空のときは "-"。試合外は "<frame> menu"
+// ====================================================================
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ai {
+
+enum class Key : std::uint8_t { Left, Right, Cw, Ccw, Soft, Hard, Hold };
+
+// press の結果（input.hpp の InputResult と同じ意味）
+struct KeyResult {
+    bool ok            = false; // 何らかの反応を検知
+    bool pieceChanged  = false; // ピースが切り替わった（新スポーン/ホールド入替含む）
+    bool lockedChanged = false; // lock 状態が変わった
+};
+
+struct GameState {
+    static constexpr int WIDTH    = 10;
+    static constexpr int HEIGHT   = 24;
+    static constexpr int NEXT_NUM = 5;
+
+    bool          inMatch = false;                // false なら以下は未設定
+    std::int32_t  frame   = -1;
+    std::array<std::uint16_t, HEIGHT> rows{};     // rows[y] の bit x = (x, y) にブロック
+    char          current = 0;                    // 落下中のミノ（0=無し）
+    bool          locked  = false;
+    std::uint64_t pieceId = 0;                    // ミノが出るたびに変わる値（PPT1 は Current 構造体のアドレス）
+    std::array<char, NEXT_NUM> next{};            // 0=無し
+    char          hold    = 0;                    // ホールド中のミノ（0=空）
+};
+
+class GameStateSource {
+public:
+    virtual ~GameStateSource() = default;
+
+    // 今の状態を読む
+    virtual void read(GameState& out) = 0;
+    // keys を同時に押し、反応（移動・回転・ピース切替）を待って離す
+    virtual KeyResult press(std::span<const Key> keys) = 0;
+    // 読んでもすることが無いとき（試合外・同じフレーム）に呼ぶ
+    virtual void idle(int ms) = 0;
+    // もう状態が来ない（リプレイの終わり・シミュの決着）。実機は常に false
+    virtual bool finished() const { return false; }
+};
+
+// ----------------------- テキスト形式 -----------------------
+inline std::string format_state(const GameState& s)
+{
+    std::ostringstream out;
+    out << s.frame << ' ';
+    if (!s.inMatch) { out << "menu"; return out.str(); }
+
+    int top = GameState::HEIGHT;
+    while (top > 0 && s.rows[top - 1] == 0) --top;
+    if (top == 0) out << '-';
+    for (int y = top - 1; y >= 0; --y) {
+        for (int x = 0; x < GameState::WIDTH; ++x) out << ((s.rows[y] >> x & 1) ? '#' : '.');
+        if (y) out << '/';
+    }
+    out << ' ' << (s.current ? s.current : '-') << ' ';
+    std::string next;
+    for (char c : s.next) if (c) next += c;
+    out << (next.empty() ? "-" : next) << ' ' << (s.hold ? s.hold : '-')
+        << ' ' << s.pieceId << ' ' << (s.locked ? 1 : 0);
+    return out.str();
+}
+
+inline GameState parse_state(const std::string& line)
+{
+    std::istringstream in(line);
+    GameState s;
+    std::string field, cur, next, hold, rest;
+    if (!(in >> s.frame >> field)) throw std::runtime_error("state: expected <frame> <board>");
+    if (field == "menu") return s;
+
+    int locked = 0;
+    if (!(in >> cur >> next >> hold >> s.pieceId >> locked) || (in >> rest))
+        throw std::runtime_error("state: expected <frame> <board> <cur> <next> <hold> <id> <locked>");
+    s.inMatch = true;
+    s.locked  = locked != 0;
+    if (field != "-") {
+        std::vector<std::string> rows;
+        std::istringstream rs(field);
+        for (std::string r; std::getline(rs, r, '/');) rows.push_back(r);
+        if (static_cast<int>(rows.size()) > GameState::HEIGHT) throw std::runtime_error("state: too many rows");
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            const std::string& r = rows[rows.size() - 1 - i];   // 最後の段が y=0
+            if (static_cast<int>(r.size()) > GameState::WIDTH) throw std::runtime_error("state: row too wide: " + r);
+            for (std::size_t x = 0; x < r.size(); ++x)
+                if (r[x] != '.' && r[x] != '_') s.rows[i] |= std::uint16_t(1u << x);
+        }
+    }
+    if (cur.size() != 1) throw std::runtime_error("state: bad current piece " + cur);
+    if (cur != "-") s.current = cur[0];
+    if (hold.size() != 1) throw std::runtime_error("state: bad hold piece " + hold);
+    if (hold != "-") s.hold = hold[0];
+    if (next != "-") {
+        if (static_cast<int>(next.size()) > GameState::NEXT_NUM) throw std::runtime_error("state: too many next pieces");
+        for (std::size_t i = 0; i < next.size(); ++i) s.next[i] = next[i];
+    }
+    return s;
+}
+
+// ----------------------- リプレイ -----------------------
+// 1 回の read で 1 行進む（空行と '#' で始まる行は飛ばす）。最後の行を読んだら finished。
+// 押されたキーは keys() に溜めるだけで、状態には効かない
+class ReplaySource : public GameStateSource {
+public:
+    explicit ReplaySource(std::istream& in)
+    {
+        for (std::string line; std::getline(in, line);) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            const auto first = line.find_first_not_of(" \t");
+            if (first == std::string::npos || line[first] == '#') continue;
+            states_.push_back(parse_state(line));
+        }
+    }
+
+    void read(GameState& out) override
+    {
+        if (pos_ < states_.size()) out = states_[pos_++];
+        else out = GameState{};
+    }
+    KeyResult press(std::span<const Key> keys) override
+    {
+        keys_.insert(keys_.end(), keys.begin(), keys.end());
+        return {};
+    }
+    void idle(int) override {}
+    bool finished() const override { return pos_ >= states_.size(); }
+
+    const std::vector<Key>& keys() const { return keys_; }
+
+private:
+    std::vector<GameState> states_;
+    std::size_t            pos_ = 0;
+    std::vector<Key>       keys_;
+};
+
+// ----------------------- 記録 -----------------------
+// 別の source をそのまま通し、フレームが変わった状態だけ out に書く（ReplaySource で読める）
+class RecordingSource : public GameStateSource {
+public:
+    RecordingSource(GameStateSource& inner, std::ostream& out) : inner_(inner), out_(out) {}
+
+    void read(GameState& s) override
+    {
+        inner_.read(s);
+        if (s.inMatch == lastInMatch_ && (!s.inMatch || s.frame == lastFrame_)) return;
+        lastInMatch_ = s.inMatch;
+        lastFrame_   = s.frame;
+        out_ << format_state(s) << '\n';
+    }
+    KeyResult press(std::span<const Key> keys) override { return inner_.press(keys); }
+    void idle(int ms) override { inner_.idle(ms); }
+    bool finished() const override { return inner_.finished(); }
+
+private:
+    GameStateSource& inner_;
+    std::ostream&    out_;
+    bool             lastInMatch_ = false;
+    std::int32_t     lastFrame_   = -1;
+};
+
+} // namespace ai
@@ -0,0 +1,148 @@
+#pragma once
+#include "block.hpp"
+#include "board.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace reachability {
+  //(ミノ, 向き, x, y) ごとのミノの盤面をコンパイル時に全部作っておく表
+  //* cells(piece, rot, x, y)   : ミノのセルだけが立つ盤面（置いた結果 = 盤面 | cells）
+  //* collides(bd, piece, ...)  : 盤外にはみ出すか盤面のブロックと重なるか（AND 1 回）
+  //* clear_above(bd, piece, ...): 各セルの真上から天井までが空か（列ごとの塗りつぶしマスクと AND 1 回）
+  //座標はミノ形状の座標系（binary_bfs / make_piece_board と同じ）。rot は向き（形状は mino_index で引く）
+  //盤面に収まらない位置は、レーン 0 の盤面外ビット（SENTINEL）を立てて持つ。
+  //判定する側の盤面にも SENTINEL を立てておけば、はみ出しも重なりと同じ AND で見つかる
+  template <typename board_t, typename RS>
+  struct piece_table {
+    using under_t = typename board_t::under_type;
+    static constexpr int W = board_t::width;
+    static constexpr int H = board_t::height;
+    static constexpr int LANES = board_t::num_of_under;
+    static constexpr int PIECES = 7;
+    static constexpr int ROTS = 4;
+    static constexpr std::size_t SIZE = std::size_t(PIECES) * ROTS * H * W;
+    static_assert(board_t::remaining_per_under > 0, "SENTINEL に使う盤面外ビットが必要");
+    static constexpr under_t SENTINEL = under_t(1) << (board_t::under_bits - 1);
+
+    // 不正なミノ文字（壊れたメモリ読み・リプレイなど）は INVALID_ID。
+    // cells は空の盤面、fits は false、collides は true（= 置けない）を返す
+    static constexpr int INVALID_ID = -1;
+    static constexpr int piece_id(char ch) {
+      switch (ch) {
+        case 'T': return 0;
+        case 'Z': return 1;
+        case 'S': return 2;
+        case 'J': return 3;
+        case 'L': return 4;
+        case 'O': return 5;
+        case 'I': return 6;
+        default: return INVALID_ID;
+      }
+    }
+    static constexpr std::size_t index(int id, int rot, int x, int y) {
+      return ((std::size_t(id) * ROTS + rot) * H + y) * W + x;
+    }
+
+    // 盤面内の anchor（x ∈ [0,W), y ∈ [0,H)）だけ表にある（どのミノも anchor 自身がセル）
+    static constexpr bool in_range(int x, int y) { return 0 <= x && x < W && 0 <= y && y < H; }
+
+    // 収まらない位置では SENTINEL が立つ（置く用途では fits を先に見る）。盤面外の anchor・不正なミノは空の盤面
+    static board_t cells(char piece, int rot, int x, int y) {
+      const int id = piece_id(piece);
+      if (id == INVALID_ID || !in_range(x, y)) return board_t{};
+      return load(cells_table.data() + index(id, rot & 3, x, y) * LANES);
+    }
+    // index(piece_id, rot, 0, 0) + y * W + x の項目（同じミノ・向きで位置だけ変えて引くとき用）
+    static board_t cells_at(std::size_t i) {
+      return load(cells_table.data() + i * LANES);
+    }
+    static bool fits(char piece, int rot, int x, int y) {
+      const int id = piece_id(piece);
+      return id != INVALID_ID && in_range(x, y) && !(cells_table[index(id, rot & 3, x, y) * LANES] & SENTINEL);
+    }
+    // 盤面 bd に SENTINEL を足したもの（同じ盤面で何度も判定するなら 1 回作って collides に渡す）
+    static board_t guarded(const board_t& bd) {
+      std::array<under_t, LANES> v{};
+      v[0] = SENTINEL;
+      return bd | board_t(v);
+    }
+    static bool collides_guarded(const board_t& guardedBd, char piece, int rot, int x, int y) {
+      const int id = piece_id(piece);
+      if (id == INVALID_ID || !in_range(x, y)) return true;
+      return (guardedBd & load(cells_table.data() + index(id, rot & 3, x, y) * LANES)).any();
+    }
+    static bool collides(const board_t& bd, char piece, int rot, int x, int y) {
+      return collides_guarded(guarded(bd), piece, rot, x, y);
+    }
+
+    // 各セルの真上から天井までの列（盤面外のセルは無視）
+    static board_t above(char piece, int rot, int x, int y) {
+      const int id = piece_id(piece);
+      board_t ret;
+      if (id == INVALID_ID) return ret;
+      const auto& m = offsets_table[id * ROTS + (rot & 3)];
+      for (const auto& c : m) {
+        const int cx = x + c[0], cy = y + c[1];
+        if (0 <= cx && cx < W && 0 <= cy && cy < H) ret |= load(column_from.data() + ((cy + 1) * W + cx) * LANES);
+      }
+      return ret;
+    }
+    static bool clear_above(const board_t& bd, char piece, int rot, int x, int y) {
+      return !(bd & above(piece, rot, x, y)).any();
+    }
+
+  private:
+    static board_t load(const under_t* p) {
+      std::array<under_t, LANES> v;
+      std::copy_n(p, LANES, v.begin());
+      return board_t(v);
+    }
+    static constexpr void set(under_t* lanes, int x, int y) {
+      lanes[y / board_t::lines_per_under] |= under_t(1) << (y % board_t::lines_per_under * W + x);
+    }
+
+    // (ミノ, 向き) ごとのセルの相対座標
+    static constexpr auto offsets_table = [] {
+      std::array<std::array<coord, 4>, PIECES * ROTS> t{};
+      auto add = [&](const auto& B, int id) {
+        for (int rot = 0; rot < ROTS; ++rot)
+          std::copy_n(B.minos[B.mino_index[rot % B.ORIENTATIONS]].begin(), 4, t[id * ROTS + rot].begin());
+      };
+      add(RS::T, 0); add(RS::Z, 1); add(RS::S, 2); add(RS::J, 3);
+      add(RS::L, 4); add(RS::O, 5); add(RS::I, 6);
+      return t;
+    }();
+
+  public:
+    // cells_table[index * LANES + lane]（1 項目 = board_t 1 個分のレーン配列）
+    alignas(64) static constexpr auto cells_table = [] {
+      std::array<under_t, SIZE * LANES> t{};
+      for (int id = 0; id < PIECES; ++id)
+        for (int rot = 0; rot < ROTS; ++rot)
+          for (int y = 0; y < H; ++y)
+            for (int x = 0; x < W; ++x) {
+              under_t* e = t.data() + index(id, rot, x, y) * LANES;
+              for (const auto& c : offsets_table[id * ROTS + rot]) {
+                const int cx = x + c[0], cy = y + c[1];
+                if (in_range(cx, cy)) set(e, cx, cy);
+                else e[0] |= SENTINEL;
+              }
+            }
+      return t;
+    }();
+
+    // column_from[(y * W + x) * LANES + lane] = x 列の y 段目から天井まで（y = H なら空）
+    alignas(64) static constexpr auto column_from = [] {
+      std::array<under_t, (H + 1) * W * LANES> t{};
+      for (int y = H - 1; y >= 0; --y)
+        for (int x = 0; x < W; ++x) {
+          std::copy_n(t.data() + ((y + 1) * W + x) * LANES, LANES, t.data() + (y * W + x) * LANES);
+          set(t.data() + (y * W + x) * LANES, x, y);
+        }
+      return t;
+    }();
+  };
+}
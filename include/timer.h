@@ -13,12 +13,13 @@ public:
     }
 
     void Start() {
-        startT = std::chrono::system_clock::now();
+        startT = std::chrono::steady_clock::now();
     }
 
+    // 経過時間 [ms]（探索の期限判定に使うので 1ms 未満も返す）
     double Elapsed() const {
-        auto now = std::chrono::system_clock::now();
-        return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(now - startT).count());
+        auto now = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(now - startT).count();
     }
 
     double TimeLimit() const {
@@ -26,6 +27,6 @@ public:
     }
 
 private:
-    std::chrono::system_clock::time_point startT;
-    double timeLimit;
+    std::chrono::steady_clock::time_point startT;
+    double timeLimit = 0;
 };
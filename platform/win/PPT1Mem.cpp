@@ -7,6 +7,7 @@
 #include <tchar.h>
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 #ifndef _MSC_VER                    // GCC/Clang など MSVC 以外
   #include <cstdio>
@@ -29,6 +30,10 @@ static uint64_t matchBaseAddress = 0;
 static uint64_t playerBaseAddress[PLAYER_MAX] = {};
 static uint64_t playerMainAddress[PLAYER_MAX] = {};
 static uint64_t fieldColumnAddress[PLAYER_MAX][10] = {};
+// 列が等間隔に並んでいるときの間隔（0 なら列ごとに読む）。このときフィールドは 1 回で読める
+static uint64_t fieldColumnStride[PLAYER_MAX] = {};
+static constexpr uint64_t FIELD_COLUMN_BYTES = sizeof(Type[FIELD_HEIGHT]);
+static constexpr uint64_t FIELD_SPAN_MAX = 0x1000;
 static uint64_t nextAddress[PLAYER_MAX] = {};
 static uint64_t poppedPieceAddress[PLAYER_MAX] = {};
 static uint64_t canHoldAddress[PLAYER_MAX] = {};
@@ -98,6 +103,32 @@ static void MemorizeFieldColumnAddress(int playerIndex)
 {
 	uint64_t fieldAddress = GetFieldAddress(playerIndex);
 	ReadProcessMemory(processHandle, (LPCVOID)fieldAddress, fieldColumnAddress[playerIndex], sizeof(fieldColumnAddress[playerIndex]), nullptr);
+
+	const uint64_t* col = fieldColumnAddress[playerIndex];
+	const uint64_t stride = col[1] - col[0];
+	bool even = col[0] != 0 && col[1] > col[0] && stride >= FIELD_COLUMN_BYTES;
+	for (int x = 2; even && x < 10; ++x)
+		even = col[x] - col[x - 1] == stride;
+	even = even && stride * 9 + FIELD_COLUMN_BYTES <= FIELD_SPAN_MAX;
+	fieldColumnStride[playerIndex] = even ? stride : 0;
+}
+static void ReadField(int playerIndex, Field_t& field)
+{
+	// 10 列をまとめて 1 回で読み、列ごとに切り出す（読めなければ以後は列ごとに読む）
+	const uint64_t stride = fieldColumnStride[playerIndex];
+	if (stride != 0)
+	{
+		alignas(8) static thread_local uint8_t buffer[FIELD_SPAN_MAX];
+		if (ReadProcessMemory(processHandle, (LPCVOID)fieldColumnAddress[playerIndex][0], buffer, stride * 9 + FIELD_COLUMN_BYTES, nullptr))
+		{
+			for (int x = 0; x < 10; ++x)
+				std::memcpy(&field[x], buffer + stride * x, FIELD_COLUMN_BYTES);
+			return;
+		}
+		fieldColumnStride[playerIndex] = 0;
+	}
+	for (int x = 0; x < 10; ++x)
+		ReadProcessMemory(processHandle, (LPCVOID)fieldColumnAddress[playerIndex][x], &field[x], sizeof(field[0]), nullptr);
 }
 static void MemorizeNextAddress(int playerIndex)
 {
@@ -296,8 +327,7 @@ bool PPT1Mem::IsOpening()
 }
 void PPT1Mem::GetField(int playerIndex, Field_t& field)
 {
-	for (int x = 0; x < 10; ++x)
-		ReadProcessMemory(processHandle, (LPCVOID)fieldColumnAddress[playerIndex][x], &field[x], sizeof(field[0]), nullptr);
+	ReadField(playerIndex, field);
 }
 void PPT1Mem::GetCurrent(int playerIndex, PPTDef::Current& current)
 {
@@ -379,4 +409,51 @@ PPTDef::CharacterSelectionPPT1 PPT1Mem::GetCharacterSelection(int playerIndex)
 	}
 	return ret;
 }
+bool PPT1Mem::ReadSnapshot(int playerIndex, Snapshot& snapshot)
+{
+	int32_t begin = GetMatchFrameCount();
+	if (snapshot.version != 0 && begin == snapshot.frame)
+	{
+		return false;
+	}
 
+	// playerMain + 0x3C8 から 現在ミノの構造体 / ホールドの構造体 / ... / REN・B2B (0x3DC) が並んでいる
+	static constexpr uint64_t MAIN_BLOCK_BEGIN = 0x3C8;
+	static constexpr uint64_t MAIN_BLOCK_END = 0x3DC + sizeof(ComboB2B);
+	static constexpr int RETRY_MAX = 3;
+
+	for (int attempt = 1; ; ++attempt)
+	{
+		uint8_t block[MAIN_BLOCK_END - MAIN_BLOCK_BEGIN] = {};
+		ReadProcessMemory(processHandle, (LPCVOID)(playerMainAddress[playerIndex] + MAIN_BLOCK_BEGIN), block, sizeof(block), nullptr);
+		uint64_t currentAddress = 0, holdAddress = 0;
+		std::memcpy(&currentAddress, block + (0x3C8 - MAIN_BLOCK_BEGIN), sizeof(currentAddress));
+		std::memcpy(&holdAddress, block + (0x3D0 - MAIN_BLOCK_BEGIN), sizeof(holdAddress));
+		std::memcpy(&snapshot.comboB2B, block + (0x3DC - MAIN_BLOCK_BEGIN), sizeof(snapshot.comboB2B));
+
+		ReadField(playerIndex, snapshot.field);
+
+		snapshot.currentAddress = currentAddress;
+		snapshot.current = Current{};
+		if (currentAddress != 0)
+			ReadProcessMemory(processHandle, (LPCVOID)(currentAddress + 0x8), &snapshot.current, sizeof(snapshot.current), nullptr);
+
+		snapshot.hold = Type::Nothing;
+		if (holdAddress >= 0x0800000) // 小さい値はホールドが空
+			ReadProcessMemory(processHandle, (LPCVOID)(holdAddress + 0x8), &snapshot.hold, sizeof(snapshot.hold), nullptr);
+
+		ReadProcessMemory(processHandle, (LPCVOID)nextAddress[playerIndex], snapshot.next, sizeof(snapshot.next), nullptr);
+
+		const int32_t after = GetMatchFrameCount();
+		snapshot.consistent = after == begin;
+		if (snapshot.consistent || attempt == RETRY_MAX)
+		{
+			break;
+		}
+		begin = after;
+	}
+	// 読み切れなかったときは読み始めのフレームにしておく（次の呼び出しで必ず読み直す）
+	snapshot.frame = begin;
+	++snapshot.version;
+	return true;
+}
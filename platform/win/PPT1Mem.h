@@ -33,6 +33,24 @@ extern bool CanHold(int playerIndex);
 extern void GetComboB2B(int playerIndex, PPTDef::ComboB2B& comboB2B);
 extern int8_t GetClearedLine(int playerIndex);
 
+// 1 フレーム分の状態（フィールド・現在・ネクスト・ホールド・REN/B2B・フレーム）をまとめて読んだもの
+struct Snapshot
+{
+	uint32_t version = 0;           // 読み直すたびに +1（0 = まだ読んでいない）
+	int32_t frame = -1;             // 読み始めの GetMatchFrameCount
+	bool consistent = false;        // 読み始めと読み終わりのフレームが同じ（途中でゲームが進まなかった）
+	uint64_t currentAddress = 0;    // Debug_GetCurrentStructAddress と同じ値（ミノが出るたびに変わる）
+	PPTDef::Field_t field = {};
+	PPTDef::Current current;
+	PPTDef::Next_t next = {};
+	PPTDef::Type hold = PPTDef::Type::Nothing;
+	PPTDef::ComboB2B comboB2B;
+};
+// snapshot.frame とフレームカウンタが同じなら何も読まずに false を返す。
+// 違えばできるだけ少ない連続読み出しで全体を読み直し、version を進めて true を返す
+// （途中でフレームが進んだら数回まで読み直す）
+extern bool ReadSnapshot(int playerIndex, Snapshot& snapshot);
+
 //<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
 extern PPTDef::CharacterSelectionPPT1 GetCharacterSelection(int playerIndex);
@@ -0,0 +1,121 @@
+#pragma once
+// PPT1MemSource.hpp — ぷよテト (PPT1) の実機を GameStateSource として見せる
+// * read  : PPT1Mem::ReadSnapshot でフィールド・現在のミノ・ネクスト・ホールドをまとめて読む
+//           （フレームが変わっていなければ前回の内容を返し、フレームカウンタ以外は読み直さない）
+//           試合・プレイヤーのアドレス（MemorizeMatchAddress）はフレームカウンタがおかしいとき
+//           （戻った / しばらく進まない）だけ引き直す。読み直してもちぎれた状態は使わない
+// * press : input.hpp の inputkey（SendInput + 反応待ち）
+#include <Windows.h>
+#include <chrono>
+#include <span>
+#include <thread>
+
+#include "PPT1Mem.h"
+#include "PPTDef.h"
+#include "input.hpp"
+#include "game_source.hpp"
+
+class PPT1MemSource : public ai::GameStateSource {
+public:
+    explicit PPT1MemSource(int playerIndex) : playerIndex_(playerIndex) {}
+
+    void read(ai::GameState& out) override
+    {
+        if (!resolved_ && !resolve()) { out = cache_; return; }
+        bool fresh = PPT1Mem::ReadSnapshot(playerIndex_, snapshot_);
+        if (!plausible(fresh)) {
+            if (!resolve()) { out = cache_; return; }
+            fresh = PPT1Mem::ReadSnapshot(playerIndex_, snapshot_);
+        }
+        // 読み直しても途中でフレームが進んだ状態は渡さず前回の状態を返す
+        //（フレームが同じなので run_bot は読み直すだけ。snapshot_.frame は古いので次の read で読み直す）
+        if (!fresh || !snapshot_.consistent) { out = cache_; return; }
+
+        const PPT1Mem::Snapshot& snap = snapshot_;
+        ai::GameState& s = cache_;
+        s = ai::GameState{};
+        s.inMatch = true;
+        s.frame   = snap.frame;
+        for (int x = 0; x < ai::GameState::WIDTH; ++x)
+            for (int y = 0; y < ai::GameState::HEIGHT; ++y)
+                if (snap.field[x][y] != PPTDef::Type::Nothing && snap.field[x][y] != PPTDef::Type::Clearing)
+                    s.rows[y] |= uint16_t(1u << x);
+        s.current = snap.currentAddress ? to_char(snap.current.type) : 0;
+        s.locked  = snap.current.locked == PPTDef::Locked::Yes;
+        s.pieceId = snap.currentAddress;
+        for (int i = 0; i < ai::GameState::NEXT_NUM && i < PPTDef::NEXT_NUM; ++i)
+            s.next[i] = to_char(snap.next[i]);
+        s.hold = to_char(snap.hold);
+        out = s;
+    }
+
+    ai::KeyResult press(std::span<const ai::Key> keys) override
+    {
+        g_input_player_index = playerIndex_;   // input.hpp のターゲットを共有
+        InputResult r{};
+        if      (keys.size() == 1) r = inputkey(playerIndex_, {to_vk(keys[0])});
+        else if (keys.size() >= 2) r = inputkey(playerIndex_, {to_vk(keys[0]), to_vk(keys[1])});
+        return {r.ok, r.pieceChanged, r.lockedChanged};
+    }
+
+    void idle(int ms) override { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+    static char to_char(PPTDef::Type t)
+    {
+        using enum PPTDef::Type;
+        switch (t) {
+        case I: return 'I'; case O: return 'O'; case T: return 'T';
+        case S: return 'S'; case Z: return 'Z'; case J: return 'J';
+        case L: return 'L'; default: return 0;
+        }
+    }
+
+    static WORD to_vk(ai::Key k)
+    {
+        switch (k) {
+        case ai::Key::Left:  return VK_LEFT;
+        case ai::Key::Right: return VK_RIGHT;
+        case ai::Key::Soft:  return 0x43;      // 'C' Fast/Soft Drop
+        case ai::Key::Cw:    return VK_UP;     // Rotate Right = ↑
+        case ai::Key::Ccw:   return VK_DOWN;   // Rotate Left  = ↓
+        case ai::Key::Hold:  return 0x56;      // 'V' Hold
+        case ai::Key::Hard:  return VK_SPACE;  // Hard Drop
+        }
+        return 0;
+    }
+
+private:
+    // フレームがこれだけ進まなければメニューに戻ったかもしれないのでアドレスを引き直す
+    static constexpr std::chrono::milliseconds STALL{500};
+
+    // 試合・プレイヤーのアドレスを引き直す。メニューなら false（状態は空にする）
+    bool resolve()
+    {
+        snapshot_   = PPT1Mem::Snapshot{};       // version 0 = 次の ReadSnapshot は必ず全部読む
+        lastFrame_  = -1;
+        lastChange_ = std::chrono::steady_clock::now();
+        resolved_   = PPT1Mem::MemorizeMatchAddress() != 0;
+        if (!resolved_) cache_ = ai::GameState{};
+        return resolved_;
+    }
+
+    // ReadSnapshot の結果がいまのアドレスで読めているか
+    //   * フレームカウンタが戻った → 次の試合になった / 読めずに 0 が返った
+    //   * STALL の間フレームが進まない → 試合が終わった（ポーズ中なら引き直しても同じ）
+    bool plausible(bool fresh)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (!fresh) return now - lastChange_ < STALL;
+        if (snapshot_.frame < lastFrame_) return false;
+        lastFrame_  = snapshot_.frame;
+        lastChange_ = now;
+        return true;
+    }
+
+    int               playerIndex_;
+    bool              resolved_ = false;
+    int32_t           lastFrame_ = -1;
+    std::chrono::steady_clock::time_point lastChange_{};
+    PPT1Mem::Snapshot snapshot_;
+    ai::GameState     cache_;
+};
@@ -0,0 +1,81 @@
+// ai_engine.cpp — ai_engine.hpp の実装（ヘッダオンリーの探索をこの TU でまとめて実体化する）
+#include "ai_engine.hpp"
+#include "ai_search.hpp"
+#include "ai_path.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ai {
+
+static_assert(EnginePosition::WIDTH == Board::width && EnginePosition::HEIGHT == Board::height,
+              "EnginePosition と探索の盤面サイズが違う");
+
+namespace {
+
+bool is_piece(char c)
+{
+    switch (c) {
+    case 'T': case 'Z': case 'S': case 'J': case 'L': case 'O': case 'I': return true;
+    default: return false;
+    }
+}
+
+double ms_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+struct Engine::Impl {
+    SearchSession session;
+};
+
+Engine::Engine() : impl_(std::make_unique<Impl>()) {}
+Engine::~Engine() = default;
+
+void Engine::set_time_limit(double ms)           { impl_->session.set_time_limit(ms); }
+void Engine::set_weights(const Weights& w)       { impl_->session.set_weights(w); }
+void Engine::load_weights(const std::string& path){ impl_->session.set_weights(ai::load_weights(path)); }
+void Engine::clear_weights()                     { impl_->session.clear_weights(); }
+
+EngineMove Engine::think(const EnginePosition& pos)
+{
+    for (char c : pos.queue)
+        if (!is_piece(c)) throw std::invalid_argument(std::string("engine: bad piece in queue: ") + c);
+    if (pos.hold != 0 && !is_piece(pos.hold))
+        throw std::invalid_argument(std::string("engine: bad hold piece: ") + pos.hold);
+
+    EngineMove mv;
+    if (pos.queue.empty()) return mv;
+
+    Board board;
+    for (int y = 0; y < Board::height; ++y)
+        for (int x = 0; x < Board::width; ++x)
+            if (pos.rows[y] >> x & 1) board.set(x, y);
+
+    const std::vector<char> queue(pos.queue.begin(), pos.queue.end());
+    const auto t0 = std::chrono::steady_clock::now();
+    const Node best = impl_->session.reset(board, queue, pos.hold);
+    mv.searchMs = ms_since(t0);
+    mv.timedOut = impl_->session.timed_out();
+    if (best.path.empty()) return mv;
+
+    const Step& s = best.path.front();
+    mv.found    = true;
+    mv.piece    = s.piece;
+    mv.usedHold = s.usedHold;
+    mv.rot      = s.rot;
+    mv.x        = s.x;
+    mv.y        = s.y;
+    mv.score    = best.score;
+
+    const auto t1 = std::chrono::steady_clock::now();
+    mv.inputs  = build_input_path(board, s);
+    mv.pathMs  = ms_since(t1);
+    return mv;
+}
+
+} // namespace ai
@@ -0,0 +1,130 @@
+// cli.cpp — 標準入出力で局面を受け取り最善手を返すヘッドレス CLI（beatris_cli）
+// ====================================================================
+// 使い方:
+//   beatris_cli [--time-ms MS] [--weights weights.txt]
+// * 1 行 1 局面:  <盤面> <キュー> [ホールド]
+//     盤面   : 上の段から '/' 区切り。最後の段が最下段（y=0）。'.' '_' が空、それ以外はブロック。
+//              1 段は 10 文字まで（足りない分は空）。空の盤面は "-"
+//     キュー : 現在のミノ + ネクスト（例 TIOSZ）
+//     ホールド: ミノ 1 文字（省略 / "-" で空）
+//   例) ..........//##########/####.##### TIO L
+// * 出力は 1 行 1 局面:
+//     move <ミノ> rot=<r> x=<x> y=<y> hold=<0|1> score=<s> search_ms=<t> path_ms=<t> inputs=<a,b,...>
+//     none search_ms=<t>      （置ける手が無い）
+//     error <理由>            （入力の誤り。次の行から続ける）
+// * 空行は読み飛ばす。"quit" で終了（盤面に '#' を使うのでコメント行は無い）
+// * --weights を省略したときは環境変数 BEATRIS_WEIGHTS の係数ファイルを使う（無ければ既定値）
+// ====================================================================
+#include "ai_engine.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    double      timeMs  = 12.0;  // ai_runner の 1 ミノあたりの探索時間と同じ
+    std::string weights;         // 空なら BEATRIS_WEIGHTS / 既定値
+};
+
+Options parse_options(int argc, char** argv)
+{
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string key = argv[i];
+        if (i + 1 >= argc) throw std::runtime_error("missing value for " + key);
+        const std::string val = argv[++i];
+        if      (key == "--time-ms") o.timeMs  = std::stod(val);
+        else if (key == "--weights") o.weights = val;
+        else throw std::runtime_error("unknown option " + key);
+    }
+    return o;
+}
+
+ai::EnginePosition parse_position(const std::string& line)
+{
+    std::istringstream in(line);
+    std::string field, queue, hold, rest;
+    if (!(in >> field >> queue)) throw std::runtime_error("expected <board> <queue> [hold]");
+    in >> hold;
+    if (in >> rest) throw std::runtime_error("unexpected token " + rest);
+
+    ai::EnginePosition pos;
+    if (field != "-") {
+        std::vector<std::string> rows;
+        std::istringstream rs(field);
+        for (std::string r; std::getline(rs, r, '/');) rows.push_back(r);
+        if (!field.empty() && field.back() == '/') rows.emplace_back();
+        if (static_cast<int>(rows.size()) > ai::EnginePosition::HEIGHT)
+            throw std::runtime_error("board: too many rows");
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            const std::string& r = rows[rows.size() - 1 - i];   // 最後の段が y=0
+            if (static_cast<int>(r.size()) > ai::EnginePosition::WIDTH)
+                throw std::runtime_error("board: row too wide: " + r);
+            for (std::size_t x = 0; x < r.size(); ++x)
+                if (r[x] != '.' && r[x] != '_') pos.rows[i] |= std::uint16_t(1u << x);
+        }
+    }
+    pos.queue = queue;
+    if (hold.size() > 1) throw std::runtime_error("hold: expected one piece");
+    if (!hold.empty() && hold != "-") pos.hold = hold[0];
+    return pos;
+}
+
+void print_move(std::ostream& out, const ai::EngineMove& mv)
+{
+    out << std::fixed << std::setprecision(3);
+    if (!mv.found) {
+        out << "none search_ms=" << mv.searchMs << '\n';
+        return;
+    }
+    out << "move " << mv.piece << " rot=" << mv.rot << " x=" << mv.x << " y=" << mv.y
+        << " hold=" << (mv.usedHold ? 1 : 0) << " score=" << mv.score
+        << " search_ms=" << mv.searchMs << " path_ms=" << mv.pathMs << " inputs=";
+    for (std::size_t i = 0; i < mv.inputs.size(); ++i) out << (i ? "," : "") << mv.inputs[i];
+    out << '\n';
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        const Options opt = parse_options(argc, argv);
+
+        ai::Engine engine;
+        engine.set_time_limit(opt.timeMs);
+        if (!opt.weights.empty()) {
+            engine.load_weights(opt.weights);
+        } else if (const char* path = std::getenv("BEATRIS_WEIGHTS")) {
+            try {
+                engine.load_weights(path);
+            } catch (const std::exception& e) {
+                std::cerr << "[cli] " << e.what() << " (using defaults)\n";
+            }
+        }
+
+        for (std::string line; std::getline(std::cin, line);) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            const auto first = line.find_first_not_of(" \t");
+            if (first == std::string::npos) continue;
+            if (line.compare(first, std::string::npos, "quit") == 0) break;
+            try {
+                print_move(std::cout, engine.think(parse_position(line)));
+            } catch (const std::exception& e) {
+                std::cout << "error " << e.what() << '\n';
+            }
+            std::cout.flush();   // パイプ越しに 1 行ずつやり取りできるように
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[cli] " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
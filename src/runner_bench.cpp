@@ -0,0 +1,109 @@
+// runner_bench.cpp — run_bot をゲームなしで回して 1 ミノあたりの遅延を測る
+// ====================================================================
+// 使い方:
+//   beatris_runner_bench [--seed S] [--pieces N] [--replay states.txt]
+//                        [--time-ms MS] [--weights weights.txt] [--verbose 0|1]
+// * 既定はシミュレータ（SimSource）。SevenBag(seed) で N 個置くまで遊ぶ
+// * --replay を付けると記録した状態（BEATRIS_RECORD で書いたもの）を流す
+// * 状態読み → 探索 → 入力列 → キー送信 の各区間の平均 / p50 / p99 / 最大 [ms] を出す
+// ====================================================================
+#include "ai_runner.hpp"
+#include "game_sim.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::uint32_t seed    = 1;
+    int           pieces  = 300;
+    std::string   replay;              // 空ならシミュレータ
+    double        timeMs  = 12.0;
+    std::string   weights;
+    bool          verbose = false;
+};
+
+Options parse_options(int argc, char** argv)
+{
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string key = argv[i];
+        if (i + 1 >= argc) throw std::runtime_error("missing value for " + key);
+        const std::string val = argv[++i];
+        if      (key == "--seed")    o.seed    = static_cast<std::uint32_t>(std::stoul(val));
+        else if (key == "--pieces")  o.pieces  = std::stoi(val);
+        else if (key == "--replay")  o.replay  = val;
+        else if (key == "--time-ms") o.timeMs  = std::stod(val);
+        else if (key == "--weights") o.weights = val;
+        else if (key == "--verbose") o.verbose = std::stoi(val) != 0;
+        else throw std::runtime_error("unknown option " + key);
+    }
+    return o;
+}
+
+void print_row(const char* name, std::vector<double> v)
+{
+    if (v.empty()) return;
+    std::sort(v.begin(), v.end());
+    double sum = 0;
+    for (double x : v) sum += x;
+    auto pct = [&](double p){ return v[std::min(v.size() - 1, std::size_t(p * double(v.size())))]; };
+    std::printf("  %-12s mean=%8.3f  p50=%8.3f  p99=%8.3f  max=%8.3f\n",
+                name, sum / double(v.size()), pct(0.50), pct(0.99), v.back());
+}
+
+void print_latency(const ai::RunnerStats& st)
+{
+    auto column = [&](double ai::PieceLatency::*m){
+        std::vector<double> v;
+        for (const auto& l : st.latency) v.push_back(l.*m);
+        return v;
+    };
+    std::printf("latency [ms] over %zu pieces\n", st.latency.size());
+    print_row("read",        column(&ai::PieceLatency::readMs));
+    print_row("search",      column(&ai::PieceLatency::searchMs));
+    print_row("path",        column(&ai::PieceLatency::pathMs));
+    print_row("first_input", column(&ai::PieceLatency::firstInputMs));
+    print_row("total",       column(&ai::PieceLatency::totalMs));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        const Options opt = parse_options(argc, argv);
+
+        ai::RunnerConf conf;
+        conf.searchBudgetMs = opt.timeMs;
+        conf.verbose        = opt.verbose;
+        if (!opt.weights.empty()) conf.weights = ai::load_weights(opt.weights);
+
+        ai::RunnerStats stats;
+        if (opt.replay.empty()) {
+            ai::SimSource sim(opt.seed, opt.pieces);
+            ai::run_bot(sim, conf, &stats);
+            std::printf("sim seed=%u pieces=%d lines=%d topped_out=%d desyncs=%d failures=%d\n",
+                        opt.seed, sim.pieces(), sim.lines(), int(sim.toppedOut()), stats.desyncs, stats.failures);
+        } else {
+            std::ifstream in(opt.replay);
+            if (!in) throw std::runtime_error("cannot open " + opt.replay);
+            ai::ReplaySource replay(in);
+            ai::run_bot(replay, conf, &stats);
+            std::printf("replay %s planned=%d keys=%zu desyncs=%d failures=%d\n",
+                        opt.replay.c_str(), stats.pieces, replay.keys().size(), stats.desyncs, stats.failures);
+        }
+        print_latency(stats);
+    } catch (const std::exception& e) {
+        std::cerr << "[runner_bench] " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+// tuner.cpp — 評価係数の自己対戦チューナー（SPSA）
+// ====================================================================
+// 使い方:
+//   beatris_tuner [--games N] [--pieces N] [--iters N] [--threads N]
+//                 [--seed S] [--attack-weight A] [--init weights.txt]
+//                 [--ckpt tuner.ckpt] [--out best.txt]
+// * 反復ごとに係数 θ を ±c_k Δ（Δ は各成分 ±1）だけずらした 2 組を同じシードの
+//   ゲームで遊ばせ、fitness の差から勾配を推定して θ を更新する（SPSA）
+// * 反復ごとに --ckpt へ θ と反復数を書き、起動時にあれば続きから再開する
+// * 最良の係数は --out に parse_weights / BEATRIS_WEIGHTS で読める形式で書く
+// ====================================================================
+#include "ai_sim.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int N_PARAMS = 5;
+using Theta = std::array<double, N_PARAMS>;
+constexpr std::array<const char*, N_PARAMS> PARAM_NAMES = {"lines", "holes", "height", "bumpiness", "wells"};
+
+Theta to_theta(const ai::Weights& w)
+{
+    return {double(w.lines), double(w.holes), double(w.height), double(w.bumpiness), double(w.wells)};
+}
+
+ai::Weights to_weights(const Theta& t)
+{
+    auto r = [](double v){ return static_cast<int>(std::lround(v)); };
+    return {r(t[0]), r(t[1]), r(t[2]), r(t[3]), r(t[4])};
+}
+
+struct Options {
+    int           games        = 64;
+    int           pieces       = 300;
+    int           iters        = 200;
+    unsigned      threads      = 0;      // 0 = hardware_concurrency
+    std::uint32_t seed         = 1;
+    double        attackWeight = 1.0;
+    std::string   init;                  // 初期係数（空なら DEFAULT_WEIGHTS）
+    std::string   ckpt         = "tuner.ckpt";
+    std::string   out          = "best_weights.txt";
+
+    // SPSA のゲイン a_k = a / (k+1+A)^0.602, c_k = max(1, c / (k+1)^0.101)
+    //（係数は整数に丸めて使うので c_k は 1 未満にしない）
+    double a = 20.0, A = 10.0, c = 2.0;
+};
+
+Options parse_options(int argc, char** argv)
+{
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string key = argv[i];
+        if (i + 1 >= argc) throw std::runtime_error("missing value for " + key);
+        const std::string val = argv[++i];
+        if      (key == "--games")         o.games        = std::stoi(val);
+        else if (key == "--pieces")        o.pieces       = std::stoi(val);
+        else if (key == "--iters")         o.iters        = std::stoi(val);
+        else if (key == "--threads")       o.threads      = static_cast<unsigned>(std::stoul(val));
+        else if (key == "--seed")          o.seed         = static_cast<std::uint32_t>(std::stoul(val));
+        else if (key == "--attack-weight") o.attackWeight = std::stod(val);
+        else if (key == "--init")          o.init         = val;
+        else if (key == "--ckpt")          o.ckpt         = val;
+        else if (key == "--out")           o.out          = val;
+        else throw std::runtime_error("unknown option " + key);
+    }
+    return o;
+}
+
+// ---- チェックポイント ------------------------------------------
+// "iteration = k" / "best = f" と θ の各成分（小数のまま）を key = value で持つ
+struct Checkpoint {
+    int    iteration = 0;
+    double best      = -1;
+    Theta  theta{};
+    Theta  bestTheta{};
+};
+
+void save_checkpoint(const std::string& path, const Checkpoint& ck)
+{
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp);
+        if (!out) throw std::runtime_error("cannot write " + tmp);
+        out.precision(17);
+        out << "iteration = " << ck.iteration << '\n'
+            << "best = "      << ck.best      << '\n';
+        for (int i = 0; i < N_PARAMS; ++i) out << PARAM_NAMES[i] << " = "      << ck.theta[i]     << '\n';
+        for (int i = 0; i < N_PARAMS; ++i) out << "best." << PARAM_NAMES[i] << " = " << ck.bestTheta[i] << '\n';
+    }
+    // 書きかけのファイルを残さない（Windows の rename は上書きしないので消してから）
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(path.c_str());
+        std::rename(tmp.c_str(), path.c_str());
+    }
+}
+
+bool load_checkpoint(const std::string& path, Checkpoint& ck)
+{
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        const auto eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        std::istringstream keyIn(line.substr(0, eq));
+        std::string key;
+        keyIn >> key;
+        const double v = std::stod(line.substr(eq + 1));
+        if (key == "iteration") { ck.iteration = static_cast<int>(v); continue; }
+        if (key == "best")      { ck.best = v; continue; }
+        for (int i = 0; i < N_PARAMS; ++i) {
+            if (key == PARAM_NAMES[i])                      ck.theta[i]     = v;
+            if (key == std::string("best.") + PARAM_NAMES[i]) ck.bestTheta[i] = v;
+        }
+    }
+    return true;
+}
+
+void save_weights(const std::string& path, const ai::Weights& w, double fit)
+{
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("cannot write " + path);
+    out << "# fitness = " << fit << '\n';
+    ai::write_weights(out, w);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        const Options opt = parse_options(argc, argv);
+
+        Checkpoint ck;
+        if (load_checkpoint(opt.ckpt, ck)) {
+            std::cerr << "[tuner] resume from " << opt.ckpt << " at iteration " << ck.iteration << '\n';
+        } else {
+            ck.theta = to_theta(opt.init.empty() ? ai::DEFAULT_WEIGHTS : ai::load_weights(opt.init));
+            ck.bestTheta = ck.theta;
+        }
+
+        ai::ThreadPool workers(opt.threads);
+        ai::SelfPlay   play(workers);
+        const ai::GameConf gc{.maxPieces = opt.pieces};
+        std::cerr << "[tuner] threads=" << workers.size() << " games=" << opt.games
+                  << " pieces=" << opt.pieces << '\n';
+
+        std::vector<std::uint32_t> seeds(opt.games);
+        while (ck.iteration < opt.iters) {
+            const int k = ck.iteration;
+            // 反復ごとに別のシード列。±の 2 組は同じシードで比べる（共通乱数）
+            std::mt19937 rng(opt.seed * 1000003u + static_cast<std::uint32_t>(k));
+            for (auto& s : seeds) s = static_cast<std::uint32_t>(rng());
+
+            const double ak = opt.a / std::pow(k + 1 + opt.A, 0.602);
+            const double step = std::max(1.0, opt.c / std::pow(k + 1, 0.101));
+            Theta delta, plus, minus;
+            for (int i = 0; i < N_PARAMS; ++i) {
+                delta[i] = (rng() & 1) ? 1.0 : -1.0;
+                plus[i]  = ck.theta[i] + step * delta[i];
+                minus[i] = ck.theta[i] - step * delta[i];
+            }
+
+            const double fPlus  = play.evaluate_weights(to_weights(plus),  seeds, gc, opt.attackWeight);
+            const double fMinus = play.evaluate_weights(to_weights(minus), seeds, gc, opt.attackWeight);
+
+            // fitness を最大化する方向へ
+            for (int i = 0; i < N_PARAMS; ++i)
+                ck.theta[i] += ak * (fPlus - fMinus) / (2 * step * delta[i]);
+
+            const double fBest = std::max(fPlus, fMinus);
+            if (fBest > ck.best) {
+                ck.best      = fBest;
+                ck.bestTheta = fPlus >= fMinus ? plus : minus;
+                save_weights(opt.out, to_weights(ck.bestTheta), ck.best);
+            }
+
+            std::cerr << "[tuner] iter " << k << " f+=" << fPlus << " f-=" << fMinus << " theta=";
+            for (double v : ck.theta) std::cerr << ' ' << v;
+            std::cerr << '\n';
+
+            ++ck.iteration;
+            save_checkpoint(opt.ckpt, ck);
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "[tuner] " << e.what() << '\n';
+        return 1;
+    }
+}
@@ -8,10 +8,14 @@
 #include "../include/block.hpp"
 #include "../include/ai_evaluate.hpp"
 #include "../include/ai_search.hpp"
+#include "../include/ai_ponder.hpp"
+#include "../include/ai_sim.hpp"
 //#define AI_SEARCH_DEBUG
 #include "../include/ai_common.hpp"
 #include "../include/draw.hpp"
 #include "../include/ai_path.hpp"
+#include "../include/ai_runner.hpp"
+#include "../include/game_sim.hpp"
 #include <iostream>
 #include <span>
 #include <cassert>
@@ -23,6 +27,8 @@
 #include <vector>
 #include <algorithm>
 #include <random>
+#include <sstream>
+#include <stdexcept>
 #include <chrono>
 #include <thread>
 #include <x86intrin.h>
@@ -717,6 +723,841 @@ void test_search_7bag()
     std::cout << "\n";
 }
 
+// 列ごとの高さ・穴 (columns / column_heights) を 1 セルずつ数えた結果と比べる
+void test_column_profile()
+{
+    // fill_down + popcount の列高さ・穴が 1 セルずつ数えた結果と一致すること
+    std::mt19937_64 rng(42);
+    for (int t = 0; t < 2000; ++t) {
+        Board b;
+        const int top = static_cast<int>(rng() % 25);
+        const int density = static_cast<int>(rng() % 100);
+        for (int y = 0; y < top; ++y)
+            for (int x = 0; x < 10; ++x)
+                if (static_cast<int>(rng() % 100) < density) b.set(x, y);
+
+        [[maybe_unused]] const auto cols = b.columns();
+        [[maybe_unused]] const auto hs   = b.column_heights();
+        int total = 0;
+        for (int x = 0; x < 10; ++x) {
+            int h = 0;
+            for (int y = 23; y >= 0; --y) if (b.get(x, y)) { h = y + 1; break; }
+            int holes = 0;
+            for (int y = 0; y < h; ++y) if (!b.get(x, y)) ++holes;
+            assert(cols.height[x] == h && hs[x] == h);
+            assert(cols.holes[x] == holes);
+            total += holes;
+        }
+        assert(cols.total_holes == total);
+    }
+    std::cout << "Test: column profile passed.\n";
+}
+
+void test_incremental_eval()
+{
+    // 差分更新した列状態が、置いた後の盤面から作り直したものと一致すること（差し込みも含む）
+    constexpr coord SPAWN{4,20};
+    std::mt19937_64 rng(7);
+    int checked = 0;
+    for (int t = 0; t < 200; ++t) {
+        Board b;
+        const int top = static_cast<int>(rng() % 12);
+        for (int y = 0; y < top; ++y)
+            for (int x = 0; x < 10; ++x)
+                if (rng() % 100 < 55) b.set(x, y);
+        const auto base = ai::column_state(b);
+        for (char p : {'I','O','T','S','Z','J','L'}) {
+            ai::for_each_landing(ai::landable<SPAWN>(b, p), p, [&](uint8_t, uint8_t, uint8_t, const Board& blk){
+                Board after = b | blk;
+                if (after.clear_full_lines() != 0) return;
+                auto cs = base;
+                ai::place_update(cs, blk);
+                [[maybe_unused]] const auto full = ai::column_state(after);
+                assert(cs == full);
+                assert((ai::evaluate<10,24>(cs, 0) == ai::evaluate(after, 0)));
+                ++checked;
+            });
+        }
+    }
+    assert(checked > 0);
+    std::cout << "Test: incremental evaluation passed.\n";
+}
+
+void test_eval_weights()
+{
+    // 係数ファイルの読み込み
+    std::istringstream in("# tuned\nholes = -25\n\n  wells=-4   # comment\n");
+    [[maybe_unused]] const ai::Weights w = ai::parse_weights(in);
+    assert(w.holes == -25 && w.wells == -4);
+    assert(w.lines == ai::DEFAULT_WEIGHTS.lines && w.height == ai::DEFAULT_WEIGHTS.height);
+    for (const char* bad : {"holes -3\n", "holes = x\n", "holes = 1 2\n", "unknown = 1\n"}) {
+        std::istringstream b(bad);
+        [[maybe_unused]] bool threw = false;
+        try { ai::parse_weights(b); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+    }
+
+    // 実行時の係数と埋め込みの係数で同じ値になる
+    [[maybe_unused]] static constexpr ai::Weights TUNED{.lines = 30, .holes = -25, .height = -2, .bumpiness = -1, .wells = -4};
+    std::mt19937_64 rng(11);
+    for (int t = 0; t < 200; ++t) {
+        Board b;
+        const int top = static_cast<int>(rng() % 16);
+        for (int y = 0; y < top; ++y)
+            for (int x = 0; x < 10; ++x)
+                if (rng() % 100 < 60) b.set(x, y);
+        [[maybe_unused]] const int lines = static_cast<int>(rng() % 5);
+        assert((ai::evaluate<10,24>(b, lines) == ai::evaluate(b, lines, ai::DEFAULT_WEIGHTS)));
+        assert((ai::evaluate<10,24,TUNED>(b, lines) == ai::evaluate(b, lines, TUNED)));
+    }
+
+    // 探索: 既定値を実行時に渡しても結果は変わらない
+    auto bag = ai::common::generate_queue(6, 3);
+    ai::SearchSession fixed, runtime;
+    runtime.set_weights(ai::DEFAULT_WEIGHTS);
+    const auto a = fixed.reset(Board{}, std::span(bag.data(), bag.size()));
+    const auto r = runtime.reset(Board{}, std::span(bag.data(), bag.size()));
+    assert(a.score == r.score && a.path.size() == r.path.size());
+    for (std::size_t i = 0; i < a.path.size(); ++i)
+        assert(a.path[i].x == r.path[i].x && a.path[i].rot == r.path[i].rot && a.path[i].piece == r.path[i].piece);
+    std::cout << "Test: evaluation weights passed.\n";
+}
+
+void test_self_play()
+{
+    // 同じシード・係数なら同じ結果。並列に遊ばせても 1 ゲームずつと一致する
+    const ai::GameConf gc{.maxPieces = 40};
+    ai::SearchSession session;
+    [[maybe_unused]] const auto a = ai::play_game(session, 5, gc);
+    [[maybe_unused]] const auto b = ai::play_game(session, 5, gc);
+    assert(a.pieces == gc.maxPieces && !a.toppedOut);
+    assert(a.pieces == b.pieces && a.lines == b.lines && a.attack == b.attack);
+    assert(a.lines > 0);
+
+    ai::ThreadPool workers(3);
+    ai::SelfPlay   play(workers);
+    const std::vector<std::uint32_t> seeds = {5, 6, 7, 8};
+    [[maybe_unused]] const double f = play.evaluate_weights(ai::DEFAULT_WEIGHTS, seeds, gc);
+    [[maybe_unused]] const auto& res = play.last_results();
+    assert(res.size() == seeds.size());
+    assert(res[0].lines == a.lines && res[0].attack == a.attack);
+    assert(f == ai::fitness(res, gc));
+
+    // 係数の書き出し → 読み込み
+    std::stringstream io;
+    static constexpr ai::Weights W{.lines = 31, .holes = -17, .height = 0, .bumpiness = -2, .wells = -5};
+    ai::write_weights(io, W);
+    assert(ai::parse_weights(io) == W);
+    std::cout << "Test: self-play simulator passed.\n";
+}
+
+void test_binary_bfs_batch()
+{
+    // まとめて計算した着地位置が 1 ミノずつの binary_bfs と一致すること
+    constexpr coord SPAWN{4,20};
+    std::mt19937_64 rng(13);
+    for (int t = 0; t < 300; ++t) {
+        Board b;
+        const int top = static_cast<int>(rng() % 18);
+        for (int y = 0; y < top; ++y)
+            for (int x = 0; x < 10; ++x)
+                if (rng() % 100 < 60) b.set(x, y);
+        std::string seen;
+        reachability::search::binary_bfs_batch<reachability::blocks::SRS, SPAWN>(b, "IOTSZJL", [&](char p, const auto& land){
+            const auto ref = reachability::search::binary_bfs<reachability::blocks::SRS, SPAWN>(b, p);
+            bool same = land.size() == ref.size();
+            for (std::size_t i = 0; same && i < ref.size(); ++i) same = !(land[i] != ref[i]);
+            assert(same);
+            seen += p;
+        });
+        assert(seen == "IOTSZJL");
+    }
+    std::cout << "Test: batched binary_bfs passed.\n";
+}
+
+void test_straight_drop()
+{
+    // 張り出しの無い低い盤面では真上から落とすだけの結果が binary_bfs と一致すること。
+    // 張り出し・高い盤面では BFS に戻るので常に一致する
+    constexpr coord SPAWN{4,20};
+    using reachability::search::binary_bfs;
+    using reachability::search::binary_bfs_fast;
+    using reachability::search::straight_drop_only;
+    std::mt19937_64 rng(17);
+    int open = 0;
+    for (int t = 0; t < 3000; ++t) {
+        const int maxh = static_cast<int>(rng() % 22);
+        Board b;
+        for (int x = 0; x < 10; ++x) {
+            const int h = static_cast<int>(rng() % (maxh + 1));
+            for (int y = 0; y < h; ++y) b.set(x, y);
+        }
+        if (t % 4 == 0) b.set(static_cast<int>(rng() % 10), maxh + 1);   // 張り出し
+        open += straight_drop_only<SPAWN>(b);
+        for (char p : {'I','O','T','S','Z','J','L'}) {
+            const auto ref  = binary_bfs<reachability::blocks::SRS, SPAWN>(b, p);
+            const auto fast = binary_bfs_fast<reachability::blocks::SRS, SPAWN>(b, p);
+            bool same = ref.size() == fast.size();
+            for (std::size_t i = 0; same && i < ref.size(); ++i) same = !(ref[i] != fast[i]);
+            assert(same);
+        }
+    }
+    assert(open > 0);
+    Board over; over.set(3, 5);
+    assert(!straight_drop_only<SPAWN>(over));
+    std::cout << "Test: straight-drop fast path passed.\n";
+}
+
+void test_input_layers()
+{
+    // 層から復元した入力列が goal に届き、そのコストが素朴な BFS（全入力コスト 1）の最短と一致すること
+    constexpr coord SPAWN{4,20};
+    std::mt19937_64 rng(19);
+    [[maybe_unused]] auto reference = [](const Board& bd, char p, const ai::Step& g){
+        int dist[10][24][4];
+        for (auto& a : dist) for (auto& b : a) for (int& d : b) d = -1;
+        std::vector<std::array<int,3>> q{{4, 20, 0}};
+        dist[4][20][0] = 0;
+        for (std::size_t h = 0; h < q.size(); ++h) {
+            const auto [x, y, r] = q[h];
+            auto push = [&](int nx, int ny, int nr){
+                if (!ai::can_place(bd, p, nx, ny, nr) || dist[nx][ny][nr] >= 0) return;
+                dist[nx][ny][nr] = dist[x][y][r] + 1;
+                q.push_back({nx, ny, nr});
+            };
+            push(x - 1, y, r); push(x + 1, y, r); push(x, y - 1, r);
+            for (int dir = 0; dir < 2; ++dir)
+                if (auto rr = ai::try_rotate(bd, p, x, y, r, dir)) push(rr->x, rr->y, rr->rot);
+        }
+        int best = -1;
+        reachability::blocks::call_with_block<ai::RS>(p, [&]<auto B>{
+            for (int r = 0; r < B.ORIENTATIONS; ++r)
+                if (B.mino_index[r] == B.mino_index[g.rot % B.ORIENTATIONS] && dist[g.x][g.y][r] >= 0
+                    && (best < 0 || dist[g.x][g.y][r] < best))
+                    best = dist[g.x][g.y][r];
+        });
+        return best;
+    };
+    const ai::TokenCost unit{.soft = 1};
+    int checked = 0;
+    for (int t = 0; t < 40; ++t) {
+        Board b;
+        const int top = static_cast<int>(rng() % 14);
+        for (int y = 0; y < top; ++y)
+            for (int x = 0; x < 10; ++x)
+                if (rng() % 100 < 55) b.set(x, y);
+        b.clear_full_lines();
+        for (char p : {'I','O','T','S','Z','J','L'}) {
+            if (!ai::can_place(b, p, 4, 20, 0)) continue;
+            ai::for_each_landing(ai::landable<SPAWN>(b, p), p, [&](uint8_t rot, uint8_t x, uint8_t y, const Board&){
+                [[maybe_unused]] const ai::Step g{p, false, rot, x, y, 0, 0};
+                ai::InputLayers layers(b, p, unit);
+                const auto hit = layers.find(x, y, rot, false);
+                assert(hit && hit->cost == reference(b, p, g));
+
+                // 復元した列を再生すると goal に着く
+                int cx = 4, cy = 20, cr = 0;
+                for (const auto& tk : layers.path_to(*hit)) {
+                    if      (tk == "left")  --cx;
+                    else if (tk == "right") ++cx;
+                    else if (tk == "soft")  --cy;
+                    else { auto r = ai::try_rotate(b, p, cx, cy, cr, tk == "cw" ? 0 : 1); assert(r); cx = r->x; cy = r->y; cr = r->rot; }
+                    assert(ai::can_place(b, p, cx, cy, cr));
+                }
+                assert(cx == x && cy == y && cr == hit->rot);
+                ++checked;
+            });
+        }
+    }
+    assert(checked > 0);
+    std::cout << "Test: input layers passed.\n";
+}
+
+void test_spin_landings()
+{
+    // 回転で入った着地位置（とキック index）が、1 マスずつ動かして回転させた結果と一致すること
+    constexpr coord SPAWN{4,20};
+    std::mt19937_64 rng(23);
+    int spins = 0;
+    for (int t = 0; t < 60; ++t) {
+        Board b;
+        const int top = static_cast<int>(rng() % 10);
+        for (int y = 0; y < top; ++y)
+            for (int x = 0; x < 10; ++x)
+                if (rng() % 100 < 55) b.set(x, y);
+        b.clear_full_lines();
+        for (char p : {'I','O','T','S','Z','J','L'}) {
+            if (!ai::can_place(b, p, 4, 20, 0)) continue;
+            const auto res  = reachability::search::binary_bfs_spin<ai::RS, SPAWN>(b, p);
+            const auto land = reachability::search::binary_bfs<ai::RS, SPAWN>(b, p);
+            assert(res.used == land.size());
+            for (std::size_t i = 0; i < land.size(); ++i) assert(!(res.land[i] != land[i]));
+
+            std::array<Board, 4> spin{};
+            std::array<std::array<Board, 5>, 4> kick{};
+            reachability::blocks::call_with_block<ai::RS>(p, [&]<auto B>{
+                bool seen[10][24][4] = {};
+                std::vector<std::array<int,3>> q{{4, 20, 0}};
+                seen[4][20][0] = true;
+                for (std::size_t h = 0; h < q.size(); ++h) {
+                    const auto [x, y, r] = q[h];
+                    auto push = [&](int nx, int ny, int nr){
+                        if (!ai::can_place(b, p, nx, ny, nr) || seen[nx][ny][nr]) return;
+                        seen[nx][ny][nr] = true;
+                        q.push_back({nx, ny, nr});
+                    };
+                    push(x - 1, y, r); push(x + 1, y, r); push(x, y - 1, r);
+                    for (int dir = 0; dir < B.ROTATIONS; ++dir) {
+                        const int to = B.rotation_target(r, dir);
+                        for (int k = 0; k < B.KICK_PER_ROTATION; ++k) {
+                            const int nx = x + B.kicks[r][dir][k][0], ny = y + B.kicks[r][dir][k][1];
+                            if (!ai::can_place(b, p, nx, ny, to)) continue;
+                            if (!ai::can_place(b, p, nx, ny - 1, to)) {
+                                spin[B.mino_index[to]].set(nx, ny);
+                                kick[B.mino_index[to]][k].set(nx, ny);
+                            }
+                            push(nx, ny, to);
+                            break;
+                        }
+                    }
+                }
+            });
+            for (std::size_t i = 0; i < res.used; ++i) {
+                assert(!(res.spin[i] != spin[i]));
+                for (int k = 0; k < 5; ++k) assert(!(res.kick[i][k] != kick[i][k]));
+                spins += res.spin[i].bitcount();
+            }
+        }
+    }
+    assert(spins > 0);
+    std::cout << "Test: spin landings passed.\n";
+}
+
+void test_line_clear_paths()
+{
+    // 行消去: pext 版とシフト版が、残った行を下から順に写した盤面と一致すること
+    // 1 手では最大 4 行だが、レーン（6 行）をまたいで 5 行以上消える盤面も試す
+    std::mt19937_64 rng(29);
+    for (int t = 0; t < 20000; ++t) {
+        Board b;
+        const int top = static_cast<int>(rng() % 25);
+        for (int y = 0; y < top; ++y) {
+            const bool full = rng() % 3 == 0;
+            for (int x = 0; x < 10; ++x)
+                if (full || rng() % 100 < 70) b.set(x, y);
+        }
+        Board ref;
+        int dst = 0;
+        for (int y = 0; y < 24; ++y) {
+            bool full = true;
+            for (int x = 0; x < 10; ++x) full &= b.get(x, y) == 1;
+            if (full) continue;
+            for (int x = 0; x < 10; ++x) if (b.get(x, y) == 1) ref.set(x, dst);
+            ++dst;
+        }
+        Board soft = b, pext = b, dispatch = b;
+        [[maybe_unused]] const int n0 = soft.clear_full_lines_impl<false>();
+        [[maybe_unused]] const int n1 = dispatch.clear_full_lines();
+        assert(n0 == 24 - dst && n1 == n0);
+        assert(!(soft != ref) && !(dispatch != ref));
+#if defined(__BMI2__)
+        [[maybe_unused]] const int n2 = pext.clear_full_lines_impl<true>();
+        assert(n2 == n0 && !(pext != ref));
+#endif
+    }
+    std::cout << "Test: line clear passed (fast pext: " << reachability::has_fast_pext << ").\n";
+}
+
+void test_garbage_rise()
+{
+    // ゴミ行の差し込み: 1 マスずつ上へ写して下 n 段を穴以外で埋めた盤面と一致し、
+    // top 段目以上へ来るブロックがあるときだけトップアウトになること
+    std::mt19937_64 rng(31);
+    std::vector<Board> boards, expect;
+    std::vector<std::uint8_t> expectOut;
+    constexpr int N = 3;
+    constexpr std::uint64_t HOLES = (1u << 2) | (1u << 7);
+    for (int t = 0; t < 3000; ++t) {
+        Board b;
+        const int top = static_cast<int>(rng() % 25);
+        for (int y = 0; y < top; ++y)
+            for (int x = 0; x < 10; ++x)
+                if (rng() % 100 < 60) b.set(x, y);
+        const int n = static_cast<int>(rng() % 25);
+        const int limit = (t & 1) ? 20 : 24;
+        const std::uint64_t holes = 1ull << (rng() % 10);
+
+        auto reference = [&](int rows, std::uint64_t hc, bool& out){
+            Board r;
+            out = false;
+            for (int y = 0; y < 24; ++y)
+                for (int x = 0; x < 10; ++x) {
+                    if (b.get(x, y) != 1) continue;
+                    if (y + rows >= limit) out = true;
+                    if (y + rows < 24) r.set(x, y + rows);
+                }
+            for (int y = 0; y < std::min(rows, 24); ++y)
+                for (int x = 0; x < 10; ++x)
+                    if (!(hc >> x & 1)) r.set(x, y);
+            return r;
+        };
+        bool out = false;
+        [[maybe_unused]] const Board ref = reference(n, holes, out);
+        Board g = b;
+        [[maybe_unused]] const bool got = g.add_garbage(n, holes, limit);
+        assert(!(g != ref) && got == out);
+        assert(g.hash() == ref.hash());
+
+        bool outN = false;
+        const Board refN = reference(N, HOLES, outN);
+        Board c = b;
+        [[maybe_unused]] const bool gotN = c.add_garbage_<N>(HOLES, limit);
+        assert(!(c != refN) && gotN == outN);
+
+        if (limit == 24) {
+            boards.push_back(b);
+            expect.push_back(refN);
+            expectOut.push_back(outN);
+        }
+    }
+    std::vector<std::uint8_t> topped(boards.size());
+    [[maybe_unused]] const int count = Board::add_garbage_batch(boards, N, HOLES, topped);
+    assert(count == std::count(expectOut.begin(), expectOut.end(), 1));
+    for (std::size_t i = 0; i < boards.size(); ++i)
+        assert(!(boards[i] != expect[i]) && topped[i] == expectOut[i]);
+    std::cout << "Test: garbage rise passed.\n";
+}
+
+void test_piece_table()
+{
+    // 表引きの衝突判定・真上判定が、セルを 1 つずつ get() で見た結果と一致すること
+    // （盤面からはみ出す位置・盤面外の anchor も含める）
+    std::mt19937_64 rng(37);
+    for (int t = 0; t < 40; ++t) {
+        Board b;
+        const int top = static_cast<int>(rng() % 20);
+        for (int y = 0; y < top; ++y)
+            for (int x = 0; x < 10; ++x)
+                if (rng() % 100 < 45) b.set(x, y);
+        for (char p : {'I','O','T','S','Z','J','L'}) {
+            reachability::blocks::call_with_block<ai::RS>(p, [&]<auto B>{
+                for (int rot = 0; rot < 4; ++rot)
+                    for (int y = -3; y < 27; ++y)
+                        for (int x = -3; x < 13; ++x) {
+                            bool fits = true;
+                            [[maybe_unused]] bool free = true, clear = true;
+                            Board cells;
+                            for (const auto& c : B.minos[B.mino_index[rot % B.ORIENTATIONS]]) {
+                                const int cx = x + c[0], cy = y + c[1];
+                                if (cx < 0 || cx >= 10 || cy < 0 || cy >= 24) { fits = false; continue; }
+                                cells.set(cx, cy);
+                                if (b.get(cx, cy) == 1) free = false;
+                                for (int yy = cy + 1; yy < 24; ++yy) if (b.get(cx, yy) == 1) clear = false;
+                            }
+                            assert(ai::PieceTable::fits(p, rot, x, y) == fits);
+                            assert(ai::can_place(b, p, x, y, rot) == (fits && free));
+                            if (!fits) continue;
+                            assert(ai::is_clear_above(b, p, x, y, rot) == clear);
+                            assert(!(ai::make_piece_board_runtime(rot, p, x, y) != cells));
+                        }
+            });
+        }
+    }
+
+    // 不正なミノ文字は置けない扱い（表の外を読まない）
+    for ([[maybe_unused]] char p : {'\0', 'X', '-', 'i'}) {
+        assert(ai::PieceTable::piece_id(p) == ai::PieceTable::INVALID_ID);
+        assert(!ai::PieceTable::fits(p, 0, 4, 10));
+        assert(ai::PieceTable::collides(Board{}, p, 0, 4, 10));
+        assert(!ai::PieceTable::cells(p, 0, 4, 10).any());
+        assert(!ai::PieceTable::above(p, 0, 4, 10).any());
+        assert(!ai::can_place(Board{}, p, 4, 10, 0));
+        assert(!ai::is_clear_above(Board{}, p, 4, 10, 0));
+    }
+    // 探索側も表を引かずに「置く場所なし」になる
+    {
+        [[maybe_unused]] int calls = 0;
+        assert((ai::landable<coord{4, 20}>(Board{}, 'X').size() == 0));
+        ai::for_each_landing(ai::landable<coord{4, 20}>(Board{}, 'T'), 'X', [&](auto...){ ++calls; });
+        assert(calls == 0);
+        ai::SearchSession session;
+        [[maybe_unused]] const std::array<char, 2> q = {'X', 'X'};
+        assert(session.reset(Board{}, q).path.empty());
+    }
+    std::cout << "Test: piece table passed.\n";
+}
+
+void test_binary_bfs_into()
+{
+    // 呼び出し側のバッファに書く版・コンパイル時ディスパッチ版・キャッシュ経由が binary_bfs と一致すること
+    constexpr coord SPAWN{4,20};
+    std::mt19937_64 rng(41);
+    ai::ReachCache<Board, 4> cache;
+    for (int t = 0; t < 50; ++t) {
+        Board b;
+        const int top = static_cast<int>(rng() % 12);
+        for (int y = 0; y < top; ++y)
+            for (int x = 0; x < 10; ++x)
+                if (rng() % 100 < 55) b.set(x, y);
+        b.clear_full_lines();
+        for (char p : {'I','O','T','S','Z','J','L'}) {
+            const auto ref = search::binary_bfs<RS,SPAWN>(b, p);
+            std::array<Board, 4> out{};
+            [[maybe_unused]] const std::size_t n  = search::binary_bfs_into<RS,SPAWN>(b, p, std::span{out});
+            [[maybe_unused]] const std::size_t nf = search::binary_bfs_fast_into<RS,SPAWN>(b, p, std::span{out});
+            assert(n == ref.size() && nf == ref.size());
+            for (std::size_t i = 0; i < n; ++i) assert(!(out[i] != ref[i]));
+
+            [[maybe_unused]] const bool same = search::visit_binary_bfs<RS,SPAWN>(b, p, [&](auto land){
+                bool ok = land.size() == ref.size();
+                for (std::size_t i = 0; i < land.size(); ++i) ok = ok && !(land[i] != ref[i]);
+                return ok;
+            });
+            assert(same);
+
+            [[maybe_unused]] const auto& cached = cache.get(b, p, [&](std::span<Board, 4> o){
+                return search::binary_bfs_fast_into<RS,SPAWN>(b, p, o);
+            });
+            assert(cached.size() == ref.size());
+            for (std::size_t i = 0; i < ref.size(); ++i) assert(!(cached[i] != ref[i]));
+        }
+    }
+    std::cout << "Test: binary_bfs into caller buffer passed.\n";
+}
+
+void test_game_source()
+{
+    // テキスト形式の往復
+    ai::GameState s;
+    s.inMatch = true;
+    s.frame   = 42;
+    s.rows[0] = 0x3DF;
+    s.rows[2] = 0x001;
+    s.current = 'T';
+    s.locked  = true;
+    s.pieceId = 7;
+    s.next    = {'I', 'O', 'S', 0, 0};
+    s.hold    = 'L';
+    const std::string line = ai::format_state(s);
+    assert(line == "42 #........./........../#####.#### T IOS L 7 1");
+    [[maybe_unused]] const ai::GameState r = ai::parse_state(line);
+    assert(r.inMatch && r.frame == 42 && r.rows == s.rows && r.current == 'T' && r.locked);
+    assert(r.pieceId == 7 && r.next == s.next && r.hold == 'L');
+    assert(ai::parse_state("3 - T - - 1 0").hold == 0);
+    assert(!ai::parse_state("5 menu").inMatch);
+    assert(ai::format_state(ai::parse_state("5 menu")) == "5 menu");
+
+    // 既定では時間で打ち切らない（RunBot は BEATRIS_SEARCH_MS を指定したときだけ anytime 探索）
+    assert(ai::RunnerConf{}.searchBudgetMs <= 0);
+
+    // シミュレータで run_bot を回し、読んだ状態を記録する
+    ai::RunnerConf rc;
+    rc.verbose = false;
+    ai::RunnerStats simStats;
+    std::stringstream rec;
+    {
+        ai::SimSource sim(3, 40);
+        ai::RecordingSource recorder(sim, rec);
+        ai::run_bot(recorder, rc, &simStats);
+        assert(sim.pieces() == 40 && !sim.toppedOut());
+    }
+    assert(simStats.pieces == 40 && simStats.desyncs == 0 && simStats.failures == 0);
+    assert(simStats.latency.size() == 40);
+
+    // 記録をリプレイすると同じ数のミノを計画し、ミノごとに hard で終わる
+    ai::ReplaySource replay(rec);
+    ai::RunnerStats replayStats;
+    ai::run_bot(replay, rc, &replayStats);
+    assert(replayStats.pieces == 40);
+    assert(std::count(replay.keys().begin(), replay.keys().end(), ai::Key::Hard) == 40);
+
+    std::cout << "Test: game_source passed.\n";
+}
+
+// TranspositionTable: 挿入・世代クリア・claim の最小 order 判定
+void test_transposition_table()
+{
+    ai::TranspositionTable tt;
+    tt.reset(100);
+    assert(tt.insert(42, 5));
+    assert(!tt.insert(42, 7));
+    assert(tt.owner(42) == 5);
+
+    tt.reset(100);                       // 世代を進めるだけで空になる
+    assert(tt.owner(42) == ai::TranspositionTable::NO_ORDER);
+
+    assert(tt.claim(7, 30));
+    assert(tt.claim(7, 10));             // より小さい order が奪う
+    assert(!tt.claim(7, 20));            // 10 に負ける
+    assert(tt.owner(7) == 10);
+
+    for (std::uint64_t k = 0; k < 10000; ++k) tt.insert(k * 0x1000 + 1);  // 拡張
+    assert(tt.owner(7) == 10);
+    std::cout << "Test: transposition table passed.\n";
+}
+
+// 厳密 dedup: key が衝突しても盤面が違えば両方残す
+void test_transposition_table_exact()
+{
+    using Exact = ai::BasicTranspositionTable<ai::ExactState>;
+    Board a, b;
+    a.set(0, 0); a.set(0, 2);
+    b.set(0, 1); b.set(0, 2);
+    [[maybe_unused]] const auto va = ai::make_state_verify<ai::ExactState>(a, 'T', 3);
+    const auto vb = ai::make_state_verify<ai::ExactState>(b, 'T', 3);
+    assert(!(va == vb));
+    assert(va == ai::make_state_verify<ai::ExactState>(Board(a), 'T', 3));
+    assert(!(va == ai::make_state_verify<ai::ExactState>(a, 'I', 3)));
+
+    [[maybe_unused]] constexpr std::uint64_t KEY = 42;   // わざと同じ key で入れる
+    Exact tt;
+    tt.reset(100);
+    assert(tt.insert(KEY, 5, va));
+    assert(tt.insert(KEY, 7, vb));      // 衝突しても盤面が違うので新規
+    assert(!tt.insert(KEY, 9, va));     // 同じ盤面は dedup
+    assert(tt.size() == 2);
+    assert(tt.owner(KEY, va) == 5);
+    assert(tt.owner(KEY, vb) == 7);
+
+    tt.reset(100);
+    assert(tt.owner(KEY, va) == Exact::NO_ORDER);
+    assert(tt.claim(KEY, 30, va));
+    assert(tt.claim(KEY, 20, vb));      // 別盤面は奪い合わない
+    assert(tt.claim(KEY, 10, va));
+    assert(!tt.claim(KEY, 25, vb));     // 20 に負ける
+    assert(tt.owner(KEY, va) == 10);
+    assert(tt.owner(KEY, vb) == 20);
+
+    for (std::uint64_t k = 0; k < 10000; ++k) tt.insert(k * 0x1000 + 1, 0, vb);  // 拡張しても照合値を保つ
+    assert(tt.owner(KEY, va) == 10);
+    assert(tt.owner(KEY, vb) == 20);
+    std::cout << "Test: exact transposition table passed.\n";
+}
+
+// 状態キー: 高さが同じで穴の位置だけ違う盤面は別キーになる
+void test_state_key()
+{
+    Board a, b;
+    a.set(0, 0); a.set(0, 2);
+    b.set(0, 1); b.set(0, 2);
+    assert(a.column_heights() == b.column_heights());
+    assert(ai::make_state_key(a, 0, 0) != ai::make_state_key(b, 0, 0));
+    assert(ai::make_state_key(a, 'T', 0) != ai::make_state_key(a, 'I', 0));
+    assert(ai::make_state_key(a, 0, 1) != ai::make_state_key(a, 0, 2));
+    assert(ai::make_state_key(a, 'T', 3) == ai::make_state_key(Board(a), 'T', 3));
+    std::cout << "Test: state key passed.\n";
+}
+
+// 状態キー計算コストの比較: 旧キー (高さシグネチャ。get() 240 回) と board_t::hash
+// 旧キーは ai_search.hpp から消したので、ここに比較用として残す
+std::uint64_t legacy_state_key(const Board& b, char hold, int pos)
+{
+    std::uint64_t k = 0;
+    for (int x = 0; x < 10; ++x) {
+        int y = 23; while (y >= 0 && !b.get(x, y)) --y;
+        k |= std::uint64_t(y + 1) << (x * 5);
+    }
+    k ^= std::uint64_t(std::uint8_t(hold))     << 50;
+    k ^= std::uint64_t(std::uint8_t(pos & 31)) << 58;
+    return k;
+}
+
+void test_state_key_bench()
+{
+    using clk = std::chrono::steady_clock;
+    std::mt19937 rng(1);
+    std::vector<Board> boards(1024);
+    for (auto& b : boards)
+        for (int x = 0; x < 10; ++x)
+            for (int y = 0, h = int(rng() % 12); y < h; ++y)
+                if (rng() % 6) b.set(x, y);
+
+    constexpr int ROUNDS = 200;
+    std::uint64_t sink = 0;
+
+    auto t0 = clk::now();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (const auto& b : boards)
+            sink ^= legacy_state_key(b, 'T', r & 31);
+    auto t1 = clk::now();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (const auto& b : boards)
+            sink ^= ai::make_state_key(b, 'T', r & 31);
+    auto t2 = clk::now();
+
+    const double n = double(ROUNDS) * boards.size();
+    std::cout << "[chrono] height signature key = "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() / n << " ns/key\n";
+    std::cout << "[chrono] board hash key       = "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() / n << " ns/key\n";
+    std::cout << "(sink " << (sink & 1) << ")\n";
+
+    // 旧キーは高さが同じで穴の位置だけ違う盤面を同一視していた
+    Board a, b;
+    a.set(0, 0); a.set(0, 2);
+    b.set(0, 1); b.set(0, 2);
+    assert(legacy_state_key(a, 0, 0) == legacy_state_key(b, 0, 0));
+    assert(ai::make_state_key(a, 0, 0) != ai::make_state_key(b, 0, 0));
+}
+
+// 空盤面で for_each_landing が形状ごとに 1 回ずつ、重複なしで置き方を列挙するか
+void test_landing_enumeration()
+{
+    // 空盤面での置き方の数（回転対称な形状は 1 回ずつだけ数える）
+    constexpr coord SPAWN{4,20};
+    const std::pair<char,int> expected[] = {
+        {'O', 9}, {'I', 17}, {'S', 17}, {'Z', 17}, {'T', 34}, {'J', 34}, {'L', 34}};
+    Board board;
+    for (auto [p, n] : expected) {
+        std::vector<Board> placed;
+        ai::for_each_landing(ai::landable<SPAWN>(board, p), p, [&](uint8_t, uint8_t, uint8_t, const Board& blk){
+            for ([[maybe_unused]] const auto& q : placed) assert(q != blk);
+            placed.push_back(blk);
+        });
+        assert(static_cast<int>(placed.size()) == n);
+    }
+    std::cout << "Test: landing enumeration passed.\n";
+}
+
+void test_reach_cache()
+{
+    constexpr coord SPAWN{4,20};
+    ai::ReachCache<Board> cache;
+    Board board;
+    for (int x = 0; x < 9; ++x) board.set(x, 0);
+    board.set(3, 1);
+
+    for (int round = 0; round < 2; ++round) {
+        for (char p : {'I','O','T','S','Z','J','L'}) {
+            auto direct = search::binary_bfs<RS,SPAWN>(board, p);
+            [[maybe_unused]] auto cached = cache.get(board, p, [&]{ return search::binary_bfs<RS,SPAWN>(board, p); });
+            assert(cached.size() == direct.size());
+            for (std::size_t i = 0; i < direct.size(); ++i) assert(!(cached[i] != direct[i]));
+        }
+    }
+    assert(cache.misses() == 7);
+    assert(cache.hits() == 7);
+    std::cout << "Test: reach cache passed.\n";
+}
+
+// 並列展開 (ThreadPool) が逐次探索と同じ結果を返すか
+void test_search_parallel()
+{
+    ai::ThreadPool workers(4);
+    for (std::uint32_t seed = 1; seed <= 3; ++seed) {
+        auto queue = ai::common::generate_queue(7, seed);
+        Board board;
+        auto serial   = ai::search(board, std::span(queue.data(), queue.size()));
+        auto parallel = ai::search(board, std::span(queue.data(), queue.size()), &workers);
+
+        assert(serial.score == parallel.score);
+        assert(!(serial.board != parallel.board));
+        assert(serial.path.size() == parallel.path.size());
+        for (size_t i = 0; i < serial.path.size(); ++i) {
+            assert(serial.path[i].piece == parallel.path[i].piece);
+            assert(serial.path[i].rot   == parallel.path[i].rot);
+            assert(serial.path[i].x     == parallel.path[i].x);
+            assert(serial.path[i].y     == parallel.path[i].y);
+        }
+    }
+    std::cout << "Test: parallel search matches serial passed.\n";
+}
+
+void test_search_session()
+{
+    // cur + next5 の窓で 1 手ずつ進め、木が再利用されることを確認
+    auto bag = ai::common::generate_queue(60, 7);
+    std::size_t head = 0;
+    char hold = 0;
+    Board board;
+    auto window = [&]{ return std::vector<char>(bag.begin() + head, bag.begin() + std::min(bag.size(), head + 6)); };
+
+    ai::SearchSession session;
+    auto q    = window();
+    auto node = session.reset(board, std::span(q.data(), q.size()), hold);
+    assert(!session.reused());
+
+    for (int turn = 0; turn < 20; ++turn) {
+        assert(!node.path.empty());
+        const ai::Step s = node.path.front();
+        board = board | ai::make_piece_board_runtime(s.rot, s.piece, s.x, s.y);
+        board.clear_full_lines();
+        if (s.usedHold) { const char q0 = bag[head]; head += (hold == 0) ? 2 : 1; hold = q0; }
+        else            { head += 1; }
+
+        q    = window();
+        node = session.advance(s, board, std::span(q.data(), q.size()), hold);
+        assert(session.reused());
+    }
+
+    // 盤面が木と食い違えば作り直す
+    const ai::Step s = node.path.front();
+    Board garbage = board;
+    assert(!garbage.get(0, 19));
+    garbage.set(0, 19);
+    q = window();
+    node = session.advance(s, garbage, std::span(q.data(), q.size()), hold);
+    assert(!session.reused());
+    assert(!node.path.empty());
+    std::cout << "Test: search session reuse passed.\n";
+}
+
+void test_search_ponder()
+{
+    // 先読みあり（Ponder）となし（advance）で同じ手順になること
+    auto bag = ai::common::generate_queue(60, 11);
+    std::size_t head = 0;
+    char hold = 0;
+    Board board;
+    auto window = [&]{ return std::vector<char>(bag.begin() + head, bag.begin() + std::min(bag.size(), head + 6)); };
+
+    ai::SearchSession plain, pondering;
+    ai::Ponder ponder(pondering);
+    auto q = window();
+    auto a = plain.reset(board, std::span(q.data(), q.size()), hold);
+    auto b = pondering.reset(board, std::span(q.data(), q.size()), hold);
+
+    int used = 0;
+    for (int turn = 0; turn < 20; ++turn) {
+        assert(a.score == b.score && a.path.size() == b.path.size());
+        const ai::Step s = a.path.front();
+        assert(s.piece == b.path.front().piece && s.x == b.path.front().x
+               && s.y == b.path.front().y && s.rot == b.path.front().rot);
+
+        ponder.start(s);
+        board = board | ai::make_piece_board_runtime(s.rot, s.piece, s.x, s.y);
+        board.clear_full_lines();
+        if (s.usedHold) { const char q0 = bag[head]; head += (hold == 0) ? 2 : 1; hold = q0; }
+        else            { head += 1; }
+
+        q = window();
+        a = plain.advance(s, board, std::span(q.data(), q.size()), hold);
+        ponder.wait();
+        b = ponder.resolve(board, std::span(q.data(), q.size()), hold);
+        assert(pondering.reused());
+        used += pondering.pondered();
+    }
+    assert(used > 0);
+    std::cout << "Test: ponder matches advance passed.\n";
+}
+
+void test_search_anytime()
+{
+    auto queue = ai::common::generate_queue(40, 5);
+    Board board;
+
+    // 期限がほぼ 0 でも root からの 1 手目は完了させて手を返す
+    auto quick = ai::search_for(board, std::span(queue.data(), queue.size()), 0.001);
+    assert(ai::thread_session().timed_out());
+    assert(!quick.path.empty());
+    assert(quick.depth == static_cast<int>(quick.path.size()));
+
+    auto full = ai::search(board, std::span(queue.data(), queue.size()));
+    assert(!ai::thread_session().timed_out());
+    assert(full.depth == ai::conf.depthMax);
+    std::cout << "Test: anytime search passed.\n";
+}
+
 void test_aipath() {
     using namespace std::chrono_literals;
 
@@ -902,6 +1743,29 @@ int main() {
     //test_tspinmaskmove2();
     //test_line_clear();
     //test_search_7bag();
+    test_column_profile();
+    test_incremental_eval();
+    test_eval_weights();
+    test_self_play();
+    test_binary_bfs_batch();
+    test_straight_drop();
+    test_input_layers();
+    test_spin_landings();
+    test_line_clear_paths();
+    test_garbage_rise();
+    test_piece_table();
+    test_binary_bfs_into();
+    test_game_source();
+    test_transposition_table();
+    test_transposition_table_exact();
+    test_state_key();
+    test_state_key_bench();
+    test_landing_enumeration();
+    test_reach_cache();
+    test_search_parallel();
+    test_search_session();
+    test_search_anytime();
+    test_search_ponder();
     test_aipath();
     std::cout << "All board tests passed.\n";
     return 0;